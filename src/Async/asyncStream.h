@@ -0,0 +1,253 @@
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <ios>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../streams/IStream.h"
+#include "../streams/memoryStream.h"
+#include "executor.h"
+#include "task.h"
+
+class IAsyncInputDataStream {
+   public:
+    // Считывает из потока не более size байт по адресу dstBuffer.
+    // Возвращает количество прочитанных байт, 0 - признак конца данных.
+    // Выбрасывает исключение std::ios_base::failure в случае ошибки
+    virtual Task<std::streamsize> ReadBlockAsync(void* dstBuffer, std::streamsize size) = 0;
+
+    // Закрывает поток. Операции над ним после этого должны выбрасывать исключение logic_error
+    virtual void Close() = 0;
+
+    virtual ~IAsyncInputDataStream() = default;
+};
+
+class IAsyncOutputDataStream {
+   public:
+    // Записывает в поток блок данных размером size байт, располагающийся по адресу srcData.
+    // В случае ошибки выбрасывает исключение std::ios_base::failure
+    virtual Task<void> WriteBlockAsync(const void* srcData, std::streamsize size) = 0;
+
+    // Дописывает накопленные данные и закрывает поток
+    virtual Task<void> CloseAsync() = 0;
+
+    virtual ~IAsyncOutputDataStream() = default;
+};
+
+using IAsyncInputPtr = std::unique_ptr<IAsyncInputDataStream>;
+using IAsyncOutputPtr = std::unique_ptr<IAsyncOutputDataStream>;
+
+/**
+ * @brief Асинхронный интерфейс над синхронным потоком ввода (например, цепочкой декораторов
+ * над файлом). Операции выполняются в вызывающем потоке исполнителя.
+ */
+class SyncInputAdapter : public IAsyncInputDataStream {
+   public:
+    explicit SyncInputAdapter(IInputPtr&& stream) : _Stream(std::move(stream)) {}
+
+    Task<std::streamsize> ReadBlockAsync(void* dstBuffer, std::streamsize size) override {
+        if (_Stream->IsEOF()) {
+            co_return 0;
+        }
+        co_return _Stream->ReadBlock(dstBuffer, size);
+    }
+
+    void Close() override { _Stream->Close(); }
+
+   private:
+    IInputPtr _Stream;
+};
+
+/**
+ * @brief Асинхронный интерфейс над синхронным потоком вывода.
+ */
+class SyncOutputAdapter : public IAsyncOutputDataStream {
+   public:
+    explicit SyncOutputAdapter(IOutputPtr&& stream) : _Stream(std::move(stream)) {}
+
+    Task<void> WriteBlockAsync(const void* srcData, std::streamsize size) override {
+        _Stream->WriteBlock(srcData, size);
+        co_return;
+    }
+
+    Task<void> CloseAsync() override {
+        _Stream->Close();
+        co_return;
+    }
+
+   private:
+    IOutputPtr _Stream;
+};
+
+/**
+ * @brief Синхронные декораторы записи перед асинхронным потоком вывода.
+ *
+ * Цепочка декораторов (например, Pipeline::WrapOutput) пишет в буфер в памяти, который
+ * после каждой записи асинхронно сбрасывается в целевой поток. Так сжатие и шифрование
+ * работают поверх неблокирующих дескрипторов без изменения самих декораторов.
+ */
+class DecoratedAsyncOutputStream : public IAsyncOutputDataStream {
+   public:
+    using Decorate = std::function<IOutputPtr(IOutputPtr)>;
+
+    DecoratedAsyncOutputStream(IAsyncOutputPtr&& target, const Decorate& decorate)
+        : _Target(std::move(target)) {
+        auto sink = std::make_unique<MemoryOutputStream>();
+        _Sink = sink.get();
+        _Chain = decorate(std::move(sink));
+    }
+
+    Task<void> WriteBlockAsync(const void* srcData, std::streamsize size) override {
+        _Chain->WriteBlock(srcData, size);
+        co_await Drain();
+    }
+
+    Task<void> CloseAsync() override {
+        _Chain->Close();
+        co_await Drain();
+        co_await _Target->CloseAsync();
+    }
+
+   private:
+    Task<void> Drain() {
+        if (!_Sink->GetData().empty()) {
+            const std::vector<uint8_t>& data = _Sink->GetData();
+            co_await _Target->WriteBlockAsync(data.data(),
+                                              static_cast<std::streamsize>(data.size()));
+            _Sink->Clear();
+        }
+    }
+
+    IAsyncOutputPtr _Target;
+    MemoryOutputStream* _Sink;
+    IOutputPtr _Chain;
+};
+
+namespace detail {
+
+// Переводит дескриптор в неблокирующий режим
+inline void SetNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::ios_base::failure("Failed to set non-blocking mode: " +
+                                     std::string(std::strerror(errno)));
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Асинхронный поток ввода над неблокирующим дескриптором (канал, сокет).
+ *
+ * Забирает владение дескриптором. Если данных нет, корутина ожидает готовности
+ * дескриптора через исполнитель, не занимая поток.
+ */
+class AsyncFdInputStream : public IAsyncInputDataStream {
+   public:
+    AsyncFdInputStream(int fd, AsyncExecutor& executor) : _Fd(fd), _Executor(executor) {
+        detail::SetNonBlocking(_Fd);
+    }
+
+    Task<std::streamsize> ReadBlockAsync(void* dstBuffer, std::streamsize size) override {
+        if (_Fd < 0) {
+            throw std::logic_error("Stream is closed");
+        }
+        while (true) {
+            const ssize_t result = ::read(_Fd, dstBuffer, static_cast<std::size_t>(size));
+            if (result >= 0) {
+                co_return result;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await _Executor.WaitReadable(_Fd);
+            } else if (errno != EINTR) {
+                throw std::ios_base::failure("Failed to read descriptor: " +
+                                             std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+    void Close() override {
+        if (_Fd >= 0) {
+            ::close(_Fd);
+            _Fd = -1;
+        }
+    }
+
+    ~AsyncFdInputStream() override { Close(); }
+
+   private:
+    int _Fd;
+    AsyncExecutor& _Executor;
+};
+
+/**
+ * @brief Асинхронный поток вывода над неблокирующим дескриптором (канал, сокет).
+ *
+ * Забирает владение дескриптором. Запись завершается, когда записан весь блок.
+ */
+class AsyncFdOutputStream : public IAsyncOutputDataStream {
+   public:
+    AsyncFdOutputStream(int fd, AsyncExecutor& executor) : _Fd(fd), _Executor(executor) {
+        detail::SetNonBlocking(_Fd);
+    }
+
+    Task<void> WriteBlockAsync(const void* srcData, std::streamsize size) override {
+        if (_Fd < 0) {
+            throw std::logic_error("Stream is closed");
+        }
+        const auto* data = static_cast<const char*>(srcData);
+        while (size > 0) {
+            const ssize_t result = ::write(_Fd, data, static_cast<std::size_t>(size));
+            if (result >= 0) {
+                data += result;
+                size -= result;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await _Executor.WaitWritable(_Fd);
+            } else if (errno != EINTR) {
+                throw std::ios_base::failure("Failed to write descriptor: " +
+                                             std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+    Task<void> CloseAsync() override {
+        Close();
+        co_return;
+    }
+
+    ~AsyncFdOutputStream() override { Close(); }
+
+   private:
+    void Close() {
+        if (_Fd >= 0) {
+            ::close(_Fd);
+            _Fd = -1;
+        }
+    }
+
+    int _Fd;
+    AsyncExecutor& _Executor;
+};
+
+/**
+ * @brief Асинхронная версия TransformData: копирует данные блоками до конца потока ввода.
+ */
+inline Task<void> TransformDataAsync(IAsyncInputDataStream& input, IAsyncOutputDataStream& output,
+                                     std::size_t blockSize = 64 << 10) {
+    std::vector<char> buffer(blockSize);
+    while (true) {
+        const std::streamsize size =
+            co_await input.ReadBlockAsync(buffer.data(), static_cast<std::streamsize>(blockSize));
+        if (size == 0) {
+            co_return;
+        }
+        co_await output.WriteBlockAsync(buffer.data(), size);
+    }
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "task.h"
+
+namespace detail {
+
+// Корутина верхнего уровня, запускаемая исполнителем и уничтожающая себя по завершении
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> Handle;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Исполнитель корутин: пул из нескольких потоков и реактор epoll для неблокирующих fd.
+ *
+ * Корутина, которой нужно дождаться готовности дескриптора, подписывается на событие
+ * через WaitReadable/WaitWritable и освобождает поток. Когда epoll сообщает о готовности,
+ * корутина снова ставится в очередь пула. Так тысячи преобразований обслуживаются
+ * несколькими потоками без отдельного стека на каждое.
+ */
+class AsyncExecutor {
+   public:
+    /**
+     * @brief Конструктор, запускающий пул потоков и реактор.
+     * @param threads Количество потоков пула.
+     * @throw std::ios_base::failure, если не удалось создать epoll или eventfd.
+     */
+    explicit AsyncExecutor(unsigned threads = 2) {
+        _Epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        _WakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (_Epoll < 0 || _WakeFd < 0) {
+            CloseDescriptors();
+            throw std::ios_base::failure("Failed to create epoll reactor: " +
+                                         std::string(std::strerror(errno)));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        ::epoll_ctl(_Epoll, EPOLL_CTL_ADD, _WakeFd, &event);
+
+        _Reactor = std::thread(&AsyncExecutor::ReactorLoop, this);
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+            _Workers.emplace_back(&AsyncExecutor::WorkerLoop, this);
+        }
+    }
+
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+    /**
+     * @brief Деструктор, дожидающийся завершения запущенных задач и останавливающий потоки.
+     */
+    ~AsyncExecutor() {
+        try {
+            Wait();
+        } catch (...) {
+        }
+        {
+            std::lock_guard lock(_Mutex);
+            _Stop = true;
+        }
+        _HasWork.notify_all();
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t result = ::write(_WakeFd, &one, sizeof(one));
+
+        for (auto& worker : _Workers) {
+            worker.join();
+        }
+        _Reactor.join();
+        CloseDescriptors();
+    }
+
+    /**
+     * @brief Запускает задачу в пуле потоков.
+     */
+    void Spawn(Task<void> task) {
+        {
+            std::lock_guard lock(_Mutex);
+            ++_Active;
+        }
+        Post(RunSpawned(std::move(task)).Handle);
+    }
+
+    /**
+     * @brief Дожидается завершения всех запущенных задач.
+     * @throw Первое исключение, выброшенное одной из задач.
+     */
+    void Wait() {
+        std::unique_lock lock(_Mutex);
+        _AllDone.wait(lock, [this] { return _Active == 0; });
+        if (_Error) {
+            std::rethrow_exception(std::exchange(_Error, nullptr));
+        }
+    }
+
+    /**
+     * @brief Ожидание готовности дескриптора к чтению или записи.
+     */
+    class FdAwaiter {
+       public:
+        FdAwaiter(AsyncExecutor& executor, int fd, uint32_t events)
+            : _Executor(executor), _Fd(fd), _Events(events) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            _Handle = handle;
+            epoll_event event{};
+            event.events = _Events | EPOLLONESHOT;
+            event.data.ptr = this;
+            if (::epoll_ctl(_Executor._Epoll, EPOLL_CTL_ADD, _Fd, &event) != 0) {
+                throw std::ios_base::failure("Failed to wait for descriptor: " +
+                                             std::string(std::strerror(errno)));
+            }
+        }
+
+        void await_resume() const noexcept {}
+
+       private:
+        friend class AsyncExecutor;
+
+        AsyncExecutor& _Executor;
+        int _Fd;
+        uint32_t _Events;
+        std::coroutine_handle<> _Handle;
+    };
+
+    FdAwaiter WaitReadable(int fd) { return {*this, fd, EPOLLIN}; }
+    FdAwaiter WaitWritable(int fd) { return {*this, fd, EPOLLOUT}; }
+
+   private:
+    detail::DetachedTask RunSpawned(Task<void> task) {
+        try {
+            co_await std::move(task);
+        } catch (...) {
+            std::lock_guard lock(_Mutex);
+            if (!_Error) {
+                _Error = std::current_exception();
+            }
+        }
+
+        std::lock_guard lock(_Mutex);
+        if (--_Active == 0) {
+            _AllDone.notify_all();
+        }
+    }
+
+    void Post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard lock(_Mutex);
+            _Ready.push_back(handle);
+        }
+        _HasWork.notify_one();
+    }
+
+    void WorkerLoop() {
+        while (true) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock lock(_Mutex);
+                _HasWork.wait(lock, [this] { return _Stop || !_Ready.empty(); });
+                if (_Ready.empty()) {
+                    return;
+                }
+                handle = _Ready.front();
+                _Ready.pop_front();
+            }
+            handle.resume();
+        }
+    }
+
+    void ReactorLoop() {
+        std::vector<epoll_event> events(64);
+        while (true) {
+            const int count =
+                ::epoll_wait(_Epoll, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::terminate();
+            }
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    return;
+                }
+                // Снимаем подписку до возобновления: корутина может сразу подписаться снова
+                auto* awaiter = static_cast<FdAwaiter*>(events[i].data.ptr);
+                ::epoll_ctl(_Epoll, EPOLL_CTL_DEL, awaiter->_Fd, nullptr);
+                Post(awaiter->_Handle);
+            }
+        }
+    }
+
+    void CloseDescriptors() {
+        if (_WakeFd >= 0) {
+            ::close(_WakeFd);
+        }
+        if (_Epoll >= 0) {
+            ::close(_Epoll);
+        }
+    }
+
+    int _Epoll = -1;
+    int _WakeFd = -1;
+    std::thread _Reactor;
+    std::vector<std::thread> _Workers;
+
+    std::mutex _Mutex;
+    std::condition_variable _HasWork;
+    std::condition_variable _AllDone;
+    std::deque<std::coroutine_handle<>> _Ready;
+    std::size_t _Active = 0;
+    std::exception_ptr _Error;
+    bool _Stop = false;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+// Общая часть promise_type: ленивый старт и возврат управления ожидающей корутине
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise().Continuation;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { Error = std::current_exception(); }
+
+    void RethrowIfFailed() const {
+        if (Error) {
+            std::rethrow_exception(Error);
+        }
+    }
+
+    std::coroutine_handle<> Continuation = std::noop_coroutine();
+    std::exception_ptr Error;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+    void return_value(T value) { Value.emplace(std::move(value)); }
+
+    T TakeResult() {
+        RethrowIfFailed();
+        return std::move(*Value);
+    }
+
+    std::optional<T> Value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+
+    void TakeResult() const { RethrowIfFailed(); }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Ленивая корутина, возвращающая значение типа T.
+ *
+ * Начинает выполнение только при co_await, по завершении передает управление ожидающей
+ * корутине (симметричная передача, без роста стека). Исключение из тела корутины
+ * пробрасывается в точку co_await.
+ */
+template <typename T>
+class Task {
+   public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : _Handle(handle) {}
+    Task(Task&& other) noexcept : _Handle(std::exchange(other._Handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Destroy();
+            _Handle = std::exchange(other._Handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        _Handle.promise().Continuation = continuation;
+        return _Handle;
+    }
+
+    T await_resume() { return _Handle.promise().TakeResult(); }
+
+   private:
+    void Destroy() {
+        if (_Handle) {
+            _Handle.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> _Handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+}  // namespace detail
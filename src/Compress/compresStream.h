@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -40,9 +41,20 @@ class CompressingOutputStream : public IOutputDataStream {
             throw std::logic_error("Stream is closed");
         }
 
+        // Обрабатываем серии целиком, а не побайтово: длинные нулевые участки
+        // сжимаются за один проход поиска
         const auto* data = static_cast<const uint8_t*>(srcData);
-        for (std::streamsize i = 0; i < size; ++i) {
-            WriteByte(data[i]);
+        const auto* end = data + size;
+        while (data < end) {
+            if (_Count == 0 || _Char != *data || _Count == 255) {
+                Flush();
+                _Char = *data;
+            }
+            const auto* limit = data + std::min<std::ptrdiff_t>(255 - _Count, end - data);
+            const auto* runEnd =
+                std::find_if(data, limit, [this](uint8_t byte) { return byte != _Char; });
+            _Count += static_cast<uint8_t>(runEnd - data);
+            data = runEnd;
         }
     };
 
@@ -123,11 +135,16 @@ class DecompressingInputStream : public IInputDataStream {
             throw std::logic_error("Stream is closed");
         }
 
+        // Серии разворачиваем заполнением, а не побайтово
         auto* buffer = static_cast<uint8_t*>(dstBuffer);
         std::streamsize readSize = 0;
 
-        for (; readSize < size && !IsEOF(); ++readSize) {
-            buffer[readSize] = ReadByte();
+        while (readSize < size && !IsEOF()) {
+            buffer[readSize++] = ReadByte();
+            const std::streamsize run = std::min<std::streamsize>(_Count, size - readSize);
+            std::fill_n(buffer + readSize, run, _Char);
+            _Count -= static_cast<uint8_t>(run);
+            readSize += run;
         }
         return readSize;
     };
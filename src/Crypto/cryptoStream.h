@@ -1,19 +1,17 @@
 #pragma once
 
-#include <algorithm>
 #include <memory>
-#include <numeric>
-#include <random>
 #include <vector>
 
 #include "../streams/IStream.h"
+#include "substitutionTables.h"
 
 /**
  * @brief Декоратор, добавляющий шифрование к потоку вывода.
  *
  * Оборачивает существующий IOutputDataStream и шифрует все записываемые
  * в него данные с помощью шифра простой замены. Таблица замен генерируется
- * на основе целочисленного ключа.
+ * на основе целочисленного ключа и берется из общего реестра SubstitutionTableRegistry.
  */
 class EncryptingOutputStream : public IOutputDataStream {
    public:
@@ -23,11 +21,8 @@ class EncryptingOutputStream : public IOutputDataStream {
      * @param key Целочисленный ключ для генерации таблицы шифрования.
      */
     EncryptingOutputStream(IOutputPtr&& fileOutputStream, uint_fast32_t key)
-        : _WrappedFileOutputStream(std::move(fileOutputStream)) {
-        _EncryptTable.resize(256);
-        std::iota(_EncryptTable.begin(), _EncryptTable.end(), 0);
-        std::shuffle(_EncryptTable.begin(), _EncryptTable.end(), std::mt19937(key));
-    }
+        : _WrappedFileOutputStream(std::move(fileOutputStream)),
+          _Tables(SubstitutionTableRegistry::Instance().Get(key)) {}
 
     /**
      * @brief Шифрует один байт и записывает его в обернутый поток.
@@ -35,7 +30,7 @@ class EncryptingOutputStream : public IOutputDataStream {
      * @throw std::ios_base::failure в случае ошибки записи в обернутый поток.
      */
     void WriteByte(uint8_t data) override {
-        _WrappedFileOutputStream->WriteByte(_EncryptTable[data]);
+        _WrappedFileOutputStream->WriteByte(_Tables->Encrypt[data]);
     };
 
     /**
@@ -45,10 +40,11 @@ class EncryptingOutputStream : public IOutputDataStream {
      * @throw std::ios_base::failure в случае ошибки записи в обернутый поток.
      */
     void WriteBlock(const void* srcData, std::streamsize size) override {
+        const SubstitutionTable& table = _Tables->Encrypt;
         std::vector<uint8_t> buffer(size);
         for (std::streamsize i = 0; i < size; ++i) {
             uint8_t data = static_cast<const uint8_t*>(srcData)[i];
-            buffer[i] = _EncryptTable[data];
+            buffer[i] = table[data];
         }
         _WrappedFileOutputStream->WriteBlock(buffer.data(), size);
     };
@@ -67,7 +63,7 @@ class EncryptingOutputStream : public IOutputDataStream {
 
    private:
     IOutputPtr _WrappedFileOutputStream;
-    std::vector<uint8_t> _EncryptTable;
+    SubstitutionTablesPtr _Tables;
 };
 
 /**
@@ -79,17 +75,9 @@ class EncryptingOutputStream : public IOutputDataStream {
  */
 class DecryptingInputStream : public IInputDataStream {
    public:
-    DecryptingInputStream(IInputPtr&& fileInputStream, uint_fast32_t key) {
-        _WrappedFileInputStream = std::move(fileInputStream);
-        std::vector<uint8_t> encryptTable(256);
-        std::iota(encryptTable.begin(), encryptTable.end(), 0);
-        std::shuffle(encryptTable.begin(), encryptTable.end(), std::mt19937(key));
-
-        _DecryptTable.resize(256);
-        for (std::streamsize i = 0; i < 256; ++i) {
-            _DecryptTable[encryptTable[i]] = static_cast<uint8_t>(i);
-        }
-    }
+    DecryptingInputStream(IInputPtr&& fileInputStream, uint_fast32_t key)
+        : _WrappedFileInputStream(std::move(fileInputStream)),
+          _Tables(SubstitutionTableRegistry::Instance().Get(key)) {}
 
     /**
      *  @brief  Возвращает признак достижения конца данных потока. Если мы в конце, peek() вернет
@@ -107,7 +95,7 @@ class DecryptingInputStream : public IInputDataStream {
      */
     uint8_t ReadByte() override {
         uint8_t encryptData = _WrappedFileInputStream->ReadByte();
-        return _DecryptTable[encryptData];
+        return _Tables->Decrypt[encryptData];
     };
 
     /**
@@ -119,9 +107,10 @@ class DecryptingInputStream : public IInputDataStream {
      */
     std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override {
         const std::streamsize readSize = _WrappedFileInputStream->ReadBlock(dstBuffer, size);
+        const SubstitutionTable& table = _Tables->Decrypt;
         auto* buffer = static_cast<uint8_t*>(dstBuffer);
         for (std::streamsize i = 0; i < readSize; ++i) {
-            buffer[i] = _DecryptTable[buffer[i]];
+            buffer[i] = table[buffer[i]];
         }
         return readSize;
     };
@@ -139,5 +128,5 @@ class DecryptingInputStream : public IInputDataStream {
 
    private:
     IInputPtr _WrappedFileInputStream;
-    std::vector<uint8_t> _DecryptTable;
+    SubstitutionTablesPtr _Tables;
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using SubstitutionTable = std::array<uint8_t, 256>;
+
+/**
+ * @brief Таблицы замен для одного ключа: шифрование и обратная ему таблица дешифрования.
+ *
+ * Неизменяемы после создания. Каждая таблица выровнена на 256 байт и целиком занимает
+ * четыре кэш-линии.
+ */
+struct SubstitutionTables {
+    alignas(256) SubstitutionTable Encrypt;
+    alignas(256) SubstitutionTable Decrypt;
+};
+
+using SubstitutionTablesPtr = std::shared_ptr<const SubstitutionTables>;
+
+/**
+ * @brief Строит обе таблицы для ключа: перемешивает байты 0..255 генератором mt19937,
+ * инициализированным ключом, и обращает полученную перестановку.
+ */
+inline SubstitutionTablesPtr MakeSubstitutionTables(uint_fast32_t key) {
+    auto tables = std::make_shared<SubstitutionTables>();
+    std::iota(tables->Encrypt.begin(), tables->Encrypt.end(), 0);
+    std::shuffle(tables->Encrypt.begin(), tables->Encrypt.end(), std::mt19937(key));
+    for (std::size_t i = 0; i < tables->Encrypt.size(); ++i) {
+        tables->Decrypt[tables->Encrypt[i]] = static_cast<uint8_t>(i);
+    }
+    return tables;
+}
+
+/**
+ * @brief Общий для процесса потокобезопасный реестр таблиц замен.
+ *
+ * Таблицы строятся один раз на ключ и разделяются всеми декораторами по ссылке, так что
+ * создание потока с уже известным ключом не требует ни генератора, ни выделения таблицы.
+ */
+class SubstitutionTableRegistry {
+   public:
+    static SubstitutionTableRegistry& Instance() {
+        static SubstitutionTableRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Возвращает таблицы для ключа, при необходимости строя их.
+     */
+    SubstitutionTablesPtr Get(uint_fast32_t key) {
+        {
+            std::shared_lock lock(_Mutex);
+            const auto found = _Tables.find(key);
+            if (found != _Tables.end()) {
+                return found->second;
+            }
+        }
+
+        // Строим вне блокировки; если другой поток успел раньше, используем его таблицы
+        SubstitutionTablesPtr tables = MakeSubstitutionTables(key);
+        std::unique_lock lock(_Mutex);
+        return _Tables.try_emplace(key, std::move(tables)).first->second;
+    }
+
+    /**
+     * @brief Заранее строит таблицы для набора ключей (например, при старте сервиса).
+     */
+    void Preload(const std::vector<uint_fast32_t>& keys) {
+        for (uint_fast32_t key : keys) {
+            Get(key);
+        }
+    }
+
+    std::size_t Size() const {
+        std::shared_lock lock(_Mutex);
+        return _Tables.size();
+    }
+
+   private:
+    SubstitutionTableRegistry() = default;
+
+    mutable std::shared_mutex _Mutex;
+    std::unordered_map<uint_fast32_t, SubstitutionTablesPtr> _Tables;
+};
+
+/**
+ * @brief Разбирает список ключей через запятую, например "3,100500".
+ * @throw std::invalid_argument, если один из ключей не является числом.
+ */
+inline std::vector<uint_fast32_t> ParseKeyring(const std::string& keyring) {
+    std::vector<uint_fast32_t> keys;
+    std::size_t begin = 0;
+    while (begin <= keyring.size()) {
+        const std::size_t end = std::min(keyring.find(',', begin), keyring.size());
+        const std::string key = keyring.substr(begin, end - begin);
+        std::size_t parsed = 0;
+        try {
+            keys.push_back(static_cast<uint32_t>(std::stoul(key, &parsed)));
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != key.size()) {
+            throw std::invalid_argument("Invalid key in keyring: " + key);
+        }
+        begin = end + 1;
+    }
+    return keys;
+}
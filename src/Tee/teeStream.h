@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../streams/IStream.h"
+
+/**
+ * @brief Поток вывода, передающий каждый записанный блок в несколько дочерних потоков.
+ *
+ * Позволяет за один проход по входным данным записать их в несколько по-разному
+ * декорированных выходов (например, сжатую копию и сжатую и зашифрованную копию).
+ * В многопоточном режиме каждая ветвь обрабатывается в своем потоке: блок копируется
+ * один раз в неизменяемый буфер со счетчиком ссылок, который разделяют все ветви.
+ */
+class TeeOutputStream : public IOutputDataStream {
+   public:
+    static constexpr std::size_t DefaultQueueDepth = 8;
+
+    /**
+     * @brief Конструктор.
+     * @param children Дочерние потоки вывода.
+     * @param threaded Обрабатывать ли каждую ветвь в отдельном потоке.
+     * @param queueDepth Максимальное количество блоков в очереди ветви; при заполнении
+     * очереди запись ожидает отстающую ветвь.
+     */
+    explicit TeeOutputStream(std::vector<IOutputPtr>&& children, bool threaded = false,
+                             std::size_t queueDepth = DefaultQueueDepth)
+        : _QueueDepth(std::max<std::size_t>(1, queueDepth)) {
+        if (children.empty()) {
+            throw std::invalid_argument("Tee requires at least one output");
+        }
+        for (auto& child : children) {
+            auto branch = std::make_unique<Branch>();
+            branch->Stream = std::move(child);
+            _Branches.push_back(std::move(branch));
+        }
+        if (threaded) {
+            for (auto& branch : _Branches) {
+                branch->Worker = std::thread(&TeeOutputStream::BranchLoop, branch.get());
+            }
+        }
+    }
+
+    /**
+     *  @brief  Записывает байт во все дочерние потоки
+     *  @throw  Выбрасывает исключение std::ios_base::failure в случае ошибки записи в любую ветвь
+     *          или std::logic_error, если поток был закрыт
+     */
+    void WriteByte(uint8_t data) override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        if (IsThreaded() == false) {
+            for (auto& branch : _Branches) {
+                branch->Stream->WriteByte(data);
+            }
+            return;
+        }
+        // Отдельные байты накапливаем, чтобы не передавать ветвям блоки по одному байту
+        _PendingBytes.push_back(static_cast<char>(data));
+        if (_PendingBytes.size() >= PendingLimit) {
+            FlushPending();
+        }
+    }
+
+    /**
+     *  @brief Записывает блок во все дочерние потоки
+     *  @throw  Выбрасывает исключение std::ios_base::failure в случае ошибки записи в любую ветвь
+     *          или std::logic_error, если поток был закрыт
+     */
+    void WriteBlock(const void* srcData, std::streamsize size) override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        if (IsThreaded() == false) {
+            for (auto& branch : _Branches) {
+                branch->Stream->WriteBlock(srcData, size);
+            }
+            return;
+        }
+        FlushPending();
+        const auto* data = static_cast<const char*>(srcData);
+        Dispatch(std::make_shared<const Block>(data, data + size));
+    }
+
+    /**
+     *  @brief Дописывает данные во все ветви и закрывает их.
+     *  @throw Первое исключение, возникшее в одной из ветвей.
+     */
+    void Close() override {
+        if (_IsClosed == true) {
+            return;
+        }
+        _IsClosed = true;
+
+        std::exception_ptr error;
+        if (IsThreaded() == true) {
+            try {
+                FlushPending();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            for (auto& branch : _Branches) {
+                {
+                    std::lock_guard lock(branch->Mutex);
+                    branch->IsDone = true;
+                }
+                branch->CanRead.notify_one();
+            }
+            for (auto& branch : _Branches) {
+                branch->Worker.join();
+                if (!error && branch->Error) {
+                    error = branch->Error;
+                }
+            }
+        } else {
+            for (auto& branch : _Branches) {
+                try {
+                    branch->Stream->Close();
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Деструктор, гарантирующий закрытие потока.
+     */
+    ~TeeOutputStream() override {
+        try {
+            Close();
+        } catch (...) {
+        }
+    }
+
+   private:
+    using Block = std::vector<char>;
+    using BlockPtr = std::shared_ptr<const Block>;
+
+    static constexpr std::size_t PendingLimit = 64 << 10;
+
+    struct Branch {
+        IOutputPtr Stream;
+        std::thread Worker;
+
+        std::mutex Mutex;
+        std::condition_variable CanRead;
+        std::condition_variable CanWrite;
+        std::deque<BlockPtr> Queue;
+        bool IsDone = false;
+        std::exception_ptr Error;
+    };
+
+    bool IsThreaded() const { return _Branches.front()->Worker.joinable(); }
+
+    void FlushPending() {
+        if (_PendingBytes.empty() == false) {
+            Dispatch(std::make_shared<const Block>(std::move(_PendingBytes)));
+            _PendingBytes.clear();
+        }
+    }
+
+    // Ставит блок в очередь каждой ветви; ошибка любой ветви прерывает запись
+    void Dispatch(const BlockPtr& block) {
+        for (auto& branch : _Branches) {
+            std::unique_lock lock(branch->Mutex);
+            branch->CanWrite.wait(
+                lock, [&] { return branch->Error || branch->Queue.size() < _QueueDepth; });
+            if (branch->Error) {
+                std::rethrow_exception(branch->Error);
+            }
+            branch->Queue.push_back(block);
+            lock.unlock();
+            branch->CanRead.notify_one();
+        }
+    }
+
+    static void BranchLoop(Branch* branch) {
+        try {
+            while (true) {
+                BlockPtr block;
+                {
+                    std::unique_lock lock(branch->Mutex);
+                    branch->CanRead.wait(
+                        lock, [branch] { return branch->IsDone || !branch->Queue.empty(); });
+                    if (branch->Queue.empty()) {
+                        break;
+                    }
+                    block = std::move(branch->Queue.front());
+                    branch->Queue.pop_front();
+                }
+                branch->CanWrite.notify_one();
+                branch->Stream->WriteBlock(block->data(),
+                                           static_cast<std::streamsize>(block->size()));
+            }
+            branch->Stream->Close();
+        } catch (...) {
+            std::lock_guard lock(branch->Mutex);
+            branch->Error = std::current_exception();
+            branch->Queue.clear();
+        }
+        branch->CanWrite.notify_one();
+    }
+
+    std::vector<std::unique_ptr<Branch>> _Branches;
+    std::size_t _QueueDepth;
+    Block _PendingBytes;
+    bool _IsClosed = false;
+};
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Crypto/substitutionTables.h"
+#include "../streams/IStream.h"
+#include "../streams/memoryStream.h"
+#include "../streams/writeStream.h"
+#include "pipeline.h"
+
+using ChunkHashKey = std::array<uint64_t, 2>;
+
+/**
+ * @brief Ключевой 64-битный хеш SipHash-2-4.
+ *
+ * Без знания ключа по значению хеша нельзя ни восстановить данные, ни проверить догадку о них.
+ */
+inline uint64_t HashChunk(const void* data, std::size_t size, const ChunkHashKey& key) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+
+    auto round = [&] {
+        v0 += v1;
+        v1 = std::rotl(v1, 13);
+        v1 ^= v0;
+        v0 = std::rotl(v0, 32);
+        v2 += v3;
+        v3 = std::rotl(v3, 16);
+        v3 ^= v2;
+        v0 += v3;
+        v3 = std::rotl(v3, 21);
+        v3 ^= v0;
+        v2 += v1;
+        v1 = std::rotl(v1, 17);
+        v1 ^= v2;
+        v2 = std::rotl(v2, 32);
+    };
+    auto mix = [&](uint64_t word) {
+        v3 ^= word;
+        round();
+        round();
+        v0 ^= word;
+    };
+
+    // Слова читаются в порядке байтов машины: манифест используется там же, где создан
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        mix(word);
+    }
+    uint64_t tail = static_cast<uint64_t>(size) << 56;
+    for (std::size_t shift = 0; i < size; ++i, shift += 8) {
+        tail |= static_cast<uint64_t>(bytes[i]) << shift;
+    }
+    mix(tail);
+
+    v2 ^= 0xff;
+    for (int j = 0; j < 4; ++j) {
+        round();
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ * @brief Отпечаток цепочки для манифеста и ключ хеширования блоков, выведенные из ее шагов.
+ *
+ * Шаги шифрования представлены своими таблицами замен, поэтому сами ключи в манифест
+ * не попадают. Ключ хеширования блоков в манифесте не хранится.
+ */
+struct PipelineSecrets {
+    uint64_t Fingerprint = 0;
+    ChunkHashKey ChunkKey{};
+};
+
+inline PipelineSecrets DerivePipelineSecrets(const Pipeline& pipeline) {
+    std::vector<uint8_t> material;
+    for (const Stage& stage : pipeline.GetStages()) {
+        material.push_back(static_cast<uint8_t>(stage.Kind));
+        if (stage.Kind == StageKind::Encrypt || stage.Kind == StageKind::Decrypt) {
+            const SubstitutionTable& table =
+                SubstitutionTableRegistry::Instance().Get(stage.Key)->Encrypt;
+            material.insert(material.end(), table.begin(), table.end());
+        }
+    }
+
+    // Разные фиксированные ключи разделяют назначения: отпечаток не раскрывает ключ блоков
+    constexpr ChunkHashKey fingerprintDomain{0x66696e6765727072ULL, 0x696e742d76320000ULL};
+    constexpr ChunkHashKey chunkKeyDomain{0x6368756e6b2d6b65ULL, 0x792d763200000000ULL};
+
+    PipelineSecrets secrets;
+    secrets.Fingerprint = HashChunk(material.data(), material.size(), fingerprintDomain);
+    material.push_back(0);
+    secrets.ChunkKey[0] = HashChunk(material.data(), material.size(), chunkKeyDomain);
+    material.back() = 1;
+    secrets.ChunkKey[1] = HashChunk(material.data(), material.size(), chunkKeyDomain);
+    return secrets;
+}
+
+/**
+ * @brief Манифест поблочного преобразования: хеши входных блоков и положение их результата
+ * в выходном файле.
+ *
+ * Хранится рядом с выходным файлом в текстовом виде. Привязан к размеру блока и отпечатку
+ * цепочки, а также к размеру выходного файла, чтобы не использовать устаревшие данные.
+ */
+struct ChunkManifest {
+    struct Entry {
+        uint64_t Hash = 0;
+        uint64_t InputSize = 0;
+        uint64_t OutputOffset = 0;
+        uint64_t OutputSize = 0;
+    };
+
+    static constexpr const char* Header = "stream-handle-manifest";
+    static constexpr int Version = 2;
+
+    uint64_t ChunkSize = 0;
+    uint64_t PipelineFingerprint = 0;
+    uint64_t OutputSize = 0;
+    std::vector<Entry> Chunks;
+
+    /**
+     * @brief Загружает манифест. Возвращает пустое значение, если файла нет или он поврежден.
+     */
+    static std::optional<ChunkManifest> Load(const std::string& fileName) {
+        std::ifstream file(fileName);
+        if (file.is_open() == false) {
+            return std::nullopt;
+        }
+
+        std::string header;
+        int version = 0;
+        std::size_t count = 0;
+        ChunkManifest manifest;
+        file >> header >> version >> manifest.ChunkSize >> std::hex >>
+            manifest.PipelineFingerprint >> std::dec >> manifest.OutputSize >> count;
+        if (!file || header != Header || version != Version || manifest.ChunkSize == 0) {
+            return std::nullopt;
+        }
+
+        // Количеству записей из файла не доверяем: записи читаются до конца файла, и каждая
+        // должна продолжать предыдущую и укладываться в размер выходного файла
+        Entry entry;
+        uint64_t offset = 0;
+        while (file >> std::hex >> entry.Hash >> std::dec >> entry.InputSize >>
+               entry.OutputOffset >> entry.OutputSize) {
+            if (manifest.Chunks.size() == count || entry.InputSize > manifest.ChunkSize ||
+                entry.OutputOffset != offset || entry.OutputSize > manifest.OutputSize - offset) {
+                return std::nullopt;
+            }
+            offset += entry.OutputSize;
+            manifest.Chunks.push_back(entry);
+        }
+        if (file.eof() == false || manifest.Chunks.size() != count ||
+            offset != manifest.OutputSize) {
+            return std::nullopt;
+        }
+        return manifest;
+    }
+
+    /**
+     * @brief Сохраняет манифест через временный файл, чтобы не оставить его недописанным.
+     * @throw std::ios_base::failure в случае ошибки записи.
+     */
+    void Save(const std::string& fileName) const {
+        const std::string tempName = fileName + ".tmp";
+        try {
+            {
+                std::ofstream file(tempName, std::ios::trunc);
+                file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+                file << Header << ' ' << Version << '\n'
+                     << ChunkSize << ' ' << std::hex << PipelineFingerprint << std::dec << '\n'
+                     << OutputSize << ' ' << Chunks.size() << '\n';
+                for (const Entry& entry : Chunks) {
+                    file << std::hex << entry.Hash << std::dec << ' ' << entry.InputSize << ' '
+                         << entry.OutputOffset << ' ' << entry.OutputSize << '\n';
+                }
+            }
+            std::filesystem::rename(tempName, fileName);
+        } catch (...) {
+            std::error_code error;
+            std::filesystem::remove(tempName, error);
+            throw;
+        }
+    }
+};
+
+/**
+ * @brief Результат инкрементального преобразования.
+ */
+struct IncrementalStats {
+    std::size_t ReusedChunks = 0;
+    std::size_t ProcessedChunks = 0;
+};
+
+constexpr std::size_t DefaultChunkSize = 1 << 20;
+constexpr std::size_t MaxChunkSize = 256 << 20;
+
+inline std::string ManifestFileName(const std::string& outputFile) {
+    return outputFile + ".manifest";
+}
+
+/**
+ * @brief Инкрементальное преобразование с манифестом хешей блоков.
+ *
+ * Входные данные делятся на блоки фиксированного размера, и каждый блок пропускается через
+ * свежую цепочку декораторов записи. Результаты блоков независимы и просто идут подряд, так
+ * что выходной файл читается обычной обратной цепочкой (--decompress, --decrypt). При
+ * повторном запуске блоки, чей хеш совпал с записанным в манифесте, не обрабатываются:
+ * их результат копируется из прежнего выходного файла. Хеши блоков вычисляются с ключом,
+ * выведенным из цепочки, поэтому манифест не позволяет проверить догадку о входных данных.
+ * @param input Поток ввода (уже обернутый декораторами чтения).
+ * @param pipeline Цепочка, из которой используются шаги записи.
+ * @throw std::ios_base::failure в случае ошибки ввода-вывода. Временный файл при этом
+ * удаляется, а прежний выходной файл остается нетронутым.
+ */
+inline IncrementalStats IncrementalTransform(IInputDataStream& input,
+                                             const std::string& outputFile,
+                                             const Pipeline& pipeline,
+                                             std::size_t chunkSize = DefaultChunkSize,
+                                             bool sparse = false) {
+    const std::string manifestFile = ManifestFileName(outputFile);
+    const PipelineSecrets secrets = DerivePipelineSecrets(pipeline);
+
+    // Прежние результаты используем, только если манифест соответствует выходному файлу
+    std::optional<ChunkManifest> previous = ChunkManifest::Load(manifestFile);
+    std::ifstream previousOutput;
+    std::error_code error;
+    if (previous && previous->ChunkSize == chunkSize &&
+        previous->PipelineFingerprint == secrets.Fingerprint &&
+        std::filesystem::file_size(outputFile, error) == previous->OutputSize && !error) {
+        previousOutput.open(outputFile, std::ios::binary);
+    }
+    if (previousOutput.is_open() == false) {
+        previous.reset();
+    }
+
+    std::unordered_map<uint64_t, const ChunkManifest::Entry*> known;
+    if (previous) {
+        for (const auto& entry : previous->Chunks) {
+            known.emplace(entry.Hash, &entry);
+        }
+    }
+
+    ChunkManifest manifest;
+    manifest.ChunkSize = chunkSize;
+    manifest.PipelineFingerprint = secrets.Fingerprint;
+
+    IncrementalStats stats;
+    const std::string tempFile = outputFile + ".tmp";
+    try {
+        FileOutputStream output{tempFile, sparse};
+        std::vector<char> chunk(chunkSize);
+        std::vector<char> reused;
+
+        while (!input.IsEOF()) {
+            std::size_t filled = 0;
+            while (filled < chunkSize && !input.IsEOF()) {
+                filled += static_cast<std::size_t>(
+                    input.ReadBlock(chunk.data() + filled,
+                                    static_cast<std::streamsize>(chunkSize - filled)));
+            }
+
+            ChunkManifest::Entry entry;
+            entry.Hash = HashChunk(chunk.data(), filled, secrets.ChunkKey);
+            entry.InputSize = filled;
+            entry.OutputOffset = manifest.OutputSize;
+
+            const auto found = known.find(entry.Hash);
+            if (found != known.end() && found->second->InputSize == filled) {
+                entry.OutputSize = found->second->OutputSize;
+                reused.resize(entry.OutputSize);
+                previousOutput.clear();
+                previousOutput.seekg(static_cast<std::streamoff>(found->second->OutputOffset));
+                previousOutput.read(reused.data(), static_cast<std::streamsize>(reused.size()));
+                if (previousOutput.gcount() != static_cast<std::streamsize>(reused.size())) {
+                    throw std::ios_base::failure("Previous output is truncated");
+                }
+                output.WriteBlock(reused.data(), static_cast<std::streamsize>(reused.size()));
+                ++stats.ReusedChunks;
+            } else {
+                // Свежая цепочка на каждый блок: результат не зависит от соседних блоков
+                auto sink = std::make_unique<MemoryOutputStream>();
+                MemoryOutputStream* sinkData = sink.get();
+                IOutputPtr chain = pipeline.WrapOutput(std::move(sink));
+                chain->WriteBlock(chunk.data(), static_cast<std::streamsize>(filled));
+                chain->Close();
+                entry.OutputSize = sinkData->GetData().size();
+                output.WriteBlock(sinkData->GetData().data(),
+                                  static_cast<std::streamsize>(entry.OutputSize));
+                ++stats.ProcessedChunks;
+            }
+
+            manifest.OutputSize += entry.OutputSize;
+            manifest.Chunks.push_back(entry);
+        }
+        output.Close();
+    } catch (...) {
+        std::error_code removeError;
+        std::filesystem::remove(tempFile, removeError);
+        throw;
+    }
+
+    // Прежний манифест удаляем до замены выходного файла, чтобы при сбое сохранения нового
+    // он не оказался рядом с чужим результатом
+    previousOutput.close();
+    std::filesystem::remove(manifestFile, error);
+    std::filesystem::rename(tempFile, outputFile);
+    manifest.Save(manifestFile);
+    return stats;
+}
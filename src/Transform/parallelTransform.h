@@ -0,0 +1,212 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../streams/writeStream.h"
+#include "pipeline.h"
+#include "transform.h"
+
+namespace detail {
+
+// Владеет файловым дескриптором и закрывает его при разрушении
+class FileDescriptor {
+   public:
+    explicit FileDescriptor(int fd) : _Fd(fd) {}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+        if (_Fd >= 0) {
+            ::close(_Fd);
+        }
+    }
+    int Get() const { return _Fd; }
+
+   private:
+    int _Fd;
+};
+
+inline std::ios_base::failure SystemFailure(const std::string& message) {
+    return std::ios_base::failure(message + ": " + std::strerror(errno));
+}
+
+// Записывает size байт по смещению offset
+inline void WriteAt(int fd, const uint8_t* data, std::size_t size, off_t offset) {
+    for (std::size_t written = 0; written < size;) {
+        const ssize_t result =
+            ::pwrite(fd, data + written, size - written, offset + static_cast<off_t>(written));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw SystemFailure("Failed to write file");
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+// Записывает данные, пропуская нулевые блоки, выровненные по SparseBlockSize. Выходной файл
+// уже имеет итоговый размер, поэтому на месте пропущенных блоков остаются дыры
+inline void WriteSparseAt(int fd, const uint8_t* data, std::size_t size, off_t offset) {
+    constexpr std::size_t sparseBlock = FileOutputStream::SparseBlockSize;
+    static constexpr uint8_t zeros[sparseBlock] = {};
+
+    std::size_t pending = 0;
+    for (std::size_t pos = 0; pos < size;) {
+        const auto position = static_cast<std::size_t>(offset) + pos;
+        const std::size_t piece = std::min(size - pos, sparseBlock - position % sparseBlock);
+        if (piece == sparseBlock && std::memcmp(data + pos, zeros, sparseBlock) == 0) {
+            WriteAt(fd, data + pending, pos - pending, offset + static_cast<off_t>(pending));
+            pending = pos + piece;
+        }
+        pos += piece;
+    }
+    WriteAt(fd, data + pending, size - pending, offset + static_cast<off_t>(pending));
+}
+
+// Обрабатывает диапазон [begin, end) входного файла и записывает результат по тому же смещению
+inline void TransformRange(int inputFd, int outputFd, off_t begin, off_t end,
+                           const SubstitutionTable& table, std::size_t blockSize, bool sparse) {
+    std::vector<uint8_t> buffer(blockSize);
+    for (off_t offset = begin; offset < end;) {
+        const std::size_t want =
+            static_cast<std::size_t>(std::min<off_t>(static_cast<off_t>(blockSize), end - offset));
+        const ssize_t readSize = ::pread(inputFd, buffer.data(), want, offset);
+        if (readSize < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw SystemFailure("Failed to read file");
+        }
+        if (readSize == 0) {
+            throw std::ios_base::failure("Input file was truncated during transform");
+        }
+
+        for (ssize_t i = 0; i < readSize; ++i) {
+            buffer[i] = table[buffer[i]];
+        }
+
+        if (sparse == true) {
+            WriteSparseAt(outputFd, buffer.data(), static_cast<std::size_t>(readSize), offset);
+        } else {
+            WriteAt(outputFd, buffer.data(), static_cast<std::size_t>(readSize), offset);
+        }
+        offset += readSize;
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Возвращает true, если файл обычный и его можно обработать ParallelTransform.
+ *
+ * Каналы и устройства не имеют известного заранее размера и не поддерживают pread,
+ * поэтому их нужно обрабатывать последовательно.
+ */
+inline bool IsRegularFile(const std::string& fileName) {
+    struct stat info {};
+    return ::stat(fileName.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+/**
+ * @brief Возвращает true, если выходной файл обычный или еще не создан, то есть ParallelTransform
+ * может задать его размер и писать в него по смещениям.
+ */
+inline bool IsRegularOrMissingFile(const std::string& fileName) {
+    struct stat info {};
+    if (::stat(fileName.c_str(), &info) != 0) {
+        return errno == ENOENT;
+    }
+    return S_ISREG(info.st_mode);
+}
+
+/**
+ * @brief Преобразует файл, разбивая его на диапазоны и обрабатывая их параллельно.
+ *
+ * Применимо только к цепочкам без состояния (Pipeline::IsStateless): каждый рабочий поток
+ * читает свой диапазон через pread, применяет свернутую таблицу замен и записывает результат
+ * через pwrite по тому же смещению в выходном файле.
+ * @param sparse Не записывать выровненные нулевые блоки, оставляя на их месте дыры.
+ * @throw std::logic_error, если цепочка содержит шаги с состоянием;
+ * std::ios_base::failure, если входной или выходной файл не обычный, или в случае ошибки
+ * ввода-вывода.
+ */
+inline void ParallelTransform(const std::string& inputFile, const std::string& outputFile,
+                              const Pipeline& pipeline, unsigned workers,
+                              std::size_t blockSize = DefaultBlockSize, bool sparse = false) {
+    const SubstitutionTable table = pipeline.ComposeSubstitution();
+
+    detail::FileDescriptor input{::open(inputFile.c_str(), O_RDONLY)};
+    if (input.Get() < 0) {
+        throw std::ios_base::failure("Failed to open file!");
+    }
+
+    // Размер из fstat достоверен только для обычного файла; у канала он нулевой
+    struct stat info {};
+    if (::fstat(input.Get(), &info) != 0) {
+        throw detail::SystemFailure("Failed to stat file");
+    }
+    if (S_ISREG(info.st_mode) == false) {
+        throw std::ios_base::failure("Parallel transform requires a regular input file");
+    }
+
+    detail::FileDescriptor output{::open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)};
+    if (output.Get() < 0) {
+        throw std::ios_base::failure("Failed to open file!");
+    }
+
+    const off_t size = info.st_size;
+
+    // Канал или устройство на выходе не поддерживают ftruncate и pwrite
+    struct stat outputInfo {};
+    if (::fstat(output.Get(), &outputInfo) != 0) {
+        throw detail::SystemFailure("Failed to stat file");
+    }
+    if (S_ISREG(outputInfo.st_mode) == false) {
+        throw std::ios_base::failure("Parallel transform requires a regular output file");
+    }
+    if (::ftruncate(output.Get(), size) != 0) {
+        throw detail::SystemFailure("Failed to resize file");
+    }
+
+    // Границы диапазонов выравниваем по размеру блока
+    workers = std::max(1u, workers);
+    const off_t block = static_cast<off_t>(blockSize);
+    const off_t rangeSize = std::max(block, (size / workers + block - 1) / block * block);
+
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        const off_t begin = rangeSize * i;
+        if (begin >= size) {
+            break;
+        }
+        const off_t end = std::min(size, begin + rangeSize);
+        threads.emplace_back([&, i, begin, end] {
+            try {
+                detail::TransformRange(input.Get(), output.Get(), begin, end, table, blockSize,
+                                       sparse);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "../Compress/compresStream.h"
+#include "../Crypto/cryptoStream.h"
+#include "../streams/IStream.h"
+
+enum class StageKind { Compress, Decompress, Encrypt, Decrypt };
+
+/**
+ * @brief Описание одного шага преобразования (декоратора) в порядке указания в командной строке.
+ */
+struct Stage {
+    StageKind Kind;
+    uint_fast32_t Key = 0;
+};
+
+/**
+ * @brief Цепочка шагов преобразования.
+ *
+ * Хранит шаги в порядке их указания и строит из них декораторы потоков ввода и вывода.
+ * Позволяет определить, что все шаги не зависят от позиции в потоке, и тогда свернуть
+ * их в одну таблицу замен для параллельной обработки независимых диапазонов.
+ */
+class Pipeline {
+   public:
+    void AddStage(Stage stage) { _Stages.push_back(stage); }
+
+    const std::vector<Stage>& GetStages() const { return _Stages; }
+
+    /**
+     * @brief Оборачивает поток ввода декораторами шагов чтения (--decompress, --decrypt).
+     */
+    IInputPtr WrapInput(IInputPtr inputStream) const {
+        for (const Stage& stage : _Stages) {
+            if (stage.Kind == StageKind::Decompress) {
+                inputStream = std::make_unique<DecompressingInputStream>(std::move(inputStream));
+            } else if (stage.Kind == StageKind::Decrypt) {
+                inputStream =
+                    std::make_unique<DecryptingInputStream>(std::move(inputStream), stage.Key);
+            }
+        }
+        return inputStream;
+    }
+
+    /**
+     * @brief Оборачивает поток вывода декораторами шагов записи (--compress, --encrypt).
+     */
+    IOutputPtr WrapOutput(IOutputPtr outputStream) const {
+        for (const Stage& stage : _Stages) {
+            if (stage.Kind == StageKind::Compress) {
+                outputStream = std::make_unique<CompressingOutputStream>(std::move(outputStream));
+            } else if (stage.Kind == StageKind::Encrypt) {
+                outputStream =
+                    std::make_unique<EncryptingOutputStream>(std::move(outputStream), stage.Key);
+            }
+        }
+        return outputStream;
+    }
+
+    /**
+     * @brief Возвращает true, если результат каждого шага зависит только от значения байта,
+     * но не от его позиции в потоке (шифрование и дешифрование заменой).
+     */
+    bool IsStateless() const {
+        for (const Stage& stage : _Stages) {
+            if (stage.Kind != StageKind::Encrypt && stage.Kind != StageKind::Decrypt) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Сворачивает цепочку без состояния в одну таблицу замен.
+     *
+     * Декораторы чтения применяются в порядке указания (первый оборачивает файл),
+     * декораторы записи - в обратном (последний указанный получает данные первым).
+     * @throw std::logic_error, если цепочка содержит шаги с состоянием.
+     */
+    SubstitutionTable ComposeSubstitution() const {
+        if (IsStateless() == false) {
+            throw std::logic_error("Pipeline contains stateful stages");
+        }
+
+        SubstitutionTable result;
+        std::iota(result.begin(), result.end(), 0);
+
+        auto apply = [&result](const SubstitutionTable& table) {
+            for (auto& value : result) {
+                value = table[value];
+            }
+        };
+
+        for (const Stage& stage : _Stages) {
+            if (stage.Kind == StageKind::Decrypt) {
+                apply(SubstitutionTableRegistry::Instance().Get(stage.Key)->Decrypt);
+            }
+        }
+        for (auto it = _Stages.rbegin(); it != _Stages.rend(); ++it) {
+            if (it->Kind == StageKind::Encrypt) {
+                apply(SubstitutionTableRegistry::Instance().Get(it->Key)->Encrypt);
+            }
+        }
+        return result;
+    }
+
+   private:
+    std::vector<Stage> _Stages;
+};
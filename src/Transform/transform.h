@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../streams/IStream.h"
+
+/**
+ * @brief Подбирает размер блока копирования по измеренной пропускной способности.
+ *
+ * На первых мегабайтах данных по очереди пробует несколько размеров блока, замеряя
+ * МБ/с через реальную цепочку декораторов, и останавливается на самом быстром.
+ * Если затем пропускная способность заметно отклоняется от замеренной, пробы повторяются.
+ */
+class BlockSizeTuner {
+   public:
+    static constexpr std::size_t DefaultProbeBytes = 4 << 20;
+    static constexpr double DefaultDriftThreshold = 0.5;
+
+    /**
+     * @brief Конструктор.
+     * @param candidates Размеры блока для проб.
+     * @param probeBytes Объем данных, прокачиваемый на каждой пробе.
+     * @param driftThreshold Допустимое относительное отклонение пропускной способности,
+     * после которого выполняются повторные пробы.
+     */
+    explicit BlockSizeTuner(std::vector<std::size_t> candidates = DefaultCandidates(),
+                            std::size_t probeBytes = DefaultProbeBytes,
+                            double driftThreshold = DefaultDriftThreshold)
+        : _Candidates(std::move(candidates)),
+          _ProbeBytes(probeBytes),
+          _DriftThreshold(driftThreshold) {
+        if (_Candidates.empty() || probeBytes == 0) {
+            throw std::invalid_argument("Invalid block size tuner configuration");
+        }
+        _Throughputs.resize(_Candidates.size());
+    }
+
+    static std::vector<std::size_t> DefaultCandidates() {
+        return {16 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20};
+    }
+
+    /**
+     * @brief Возвращает размер блока, который следует использовать для следующей операции.
+     */
+    std::size_t GetBlockSize() const { return _Candidates[_Current]; }
+
+    /**
+     * @brief Возвращает наибольший из возможных размеров блока (для выделения буфера).
+     */
+    std::size_t GetMaxBlockSize() const {
+        return *std::max_element(_Candidates.begin(), _Candidates.end());
+    }
+
+    /**
+     * @brief Возвращает true, если пробы завершены и размер блока выбран.
+     */
+    bool IsSettled() const { return _IsSettled; }
+
+    /**
+     * @brief Учитывает очередную операцию копирования блоком текущего размера.
+     * @param bytes Количество обработанных байт.
+     * @param elapsed Время, затраченное на обработку.
+     */
+    void Record(std::size_t bytes, std::chrono::nanoseconds elapsed) {
+        _WindowBytes += bytes;
+        _WindowTime += elapsed;
+
+        const std::size_t windowLimit = _IsSettled ? _ProbeBytes * _Candidates.size() : _ProbeBytes;
+        if (_WindowBytes < windowLimit) {
+            return;
+        }
+
+        const double throughput = Throughput();
+        _WindowBytes = 0;
+        _WindowTime = std::chrono::nanoseconds::zero();
+
+        if (_IsSettled) {
+            const double drift = std::abs(throughput - _SettledThroughput) / _SettledThroughput;
+            if (drift > _DriftThreshold) {
+                _IsSettled = false;
+                _Current = 0;
+            }
+            return;
+        }
+
+        _Throughputs[_Current] = throughput;
+        if (++_Current < _Candidates.size()) {
+            return;
+        }
+
+        const auto best = std::max_element(_Throughputs.begin(), _Throughputs.end());
+        _Current = static_cast<std::size_t>(best - _Throughputs.begin());
+        _SettledThroughput = *best;
+        _IsSettled = true;
+    }
+
+   private:
+    // Пропускная способность текущего окна в МБ/с
+    double Throughput() const {
+        const double seconds =
+            std::max(std::chrono::duration<double>(_WindowTime).count(), 1e-9);
+        return static_cast<double>(_WindowBytes) / (1 << 20) / seconds;
+    }
+
+    std::vector<std::size_t> _Candidates;
+    std::vector<double> _Throughputs;
+    std::size_t _ProbeBytes;
+    double _DriftThreshold;
+
+    std::size_t _Current = 0;
+    bool _IsSettled = false;
+    double _SettledThroughput = 0;
+
+    std::size_t _WindowBytes = 0;
+    std::chrono::nanoseconds _WindowTime = std::chrono::nanoseconds::zero();
+};
+
+constexpr std::size_t DefaultBlockSize = 64 << 10;
+constexpr std::size_t MaxBlockSize = 256 << 20;
+
+/**
+ * @brief Копирует данные из потока ввода в поток вывода блоками фиксированного размера.
+ */
+inline void TransformData(IInputDataStream& input, IOutputDataStream& output,
+                          std::size_t blockSize = DefaultBlockSize) {
+    std::vector<char> buffer(blockSize);
+    while (!input.IsEOF()) {
+        std::streamsize size = input.ReadBlock(buffer.data(), buffer.size());
+        if (size > 0) {
+            output.WriteBlock(buffer.data(), size);
+        }
+    }
+}
+
+/**
+ * @brief Копирует данные из потока ввода в поток вывода, подбирая размер блока на лету.
+ *
+ * Выбранный размер блока доступен через tuner.GetBlockSize() после завершения.
+ */
+inline void TransformData(IInputDataStream& input, IOutputDataStream& output,
+                          BlockSizeTuner& tuner) {
+    std::vector<char> buffer(tuner.GetMaxBlockSize());
+    while (!input.IsEOF()) {
+        const auto start = std::chrono::steady_clock::now();
+        std::streamsize size =
+            input.ReadBlock(buffer.data(), static_cast<std::streamsize>(tuner.GetBlockSize()));
+        if (size > 0) {
+            output.WriteBlock(buffer.data(), size);
+        }
+        tuner.Record(static_cast<std::size_t>(size), std::chrono::steady_clock::now() - start);
+    }
+}
@@ -1,81 +1,250 @@
+#include <cctype>
 #include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#include "Compress/compresStream.h"
-#include "Crypto/cryptoStream.h"
+#include "Crypto/substitutionTables.h"
+#include "Tee/teeStream.h"
+#include "Transform/incrementalTransform.h"
+#include "Transform/parallelTransform.h"
+#include "Transform/pipeline.h"
+#include "Transform/transform.h"
+#include "streams/prefetchReadStream.h"
 #include "streams/readStream.h"
 #include "streams/writeStream.h"
 
-void TransformData(IInputDataStream& input, IOutputDataStream& output) {
-    std::vector<char> buffer(4096);
-    while (!input.IsEOF()) {
-        std::streamsize size = input.ReadBlock(buffer.data(), buffer.size());
-        if (size > 0) {
-            output.WriteBlock(buffer.data(), size);
+// Разбирает ключ шифрования, переданный опции option
+uint32_t ParseKey(const std::string& option, const std::string& value) {
+    try {
+        return (uint32_t)std::stoul(value);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid key for " + option + " option: " + value);
+    }
+}
+
+// Разбирает положительное целое значение опции option, не превышающее maxValue
+std::size_t ParseSize(const std::string& option, const std::string& value, std::size_t maxValue) {
+    std::size_t parsed = 0;
+    unsigned long long result = 0;
+    try {
+        // stoull принимает знак минус и молча оборачивает значение, поэтому требуем цифру
+        if (value.empty() == false && std::isdigit(static_cast<unsigned char>(value[0]))) {
+            result = std::stoull(value, &parsed);
+        }
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != value.size() || result == 0 || result > maxValue) {
+        throw std::invalid_argument("Invalid value for " + option + " option: " + value);
+    }
+    return static_cast<std::size_t>(result);
+}
+
+// Наибольшее допустимое значение --jobs
+constexpr std::size_t MaxJobs = 1024;
+
+// Выходной файл с собственной цепочкой декораторов записи (--tee)
+struct OutputSpec {
+    std::string FileName;
+    Pipeline Stages;
+    bool Sparse = false;
+};
+
+// Разбирает группы "--tee [опции] <output-file>", начиная с позиции first
+std::vector<OutputSpec> ParseTeeOutputs(int first, int argc, char** argv) {
+    std::vector<OutputSpec> outputs;
+    for (int i = first; i < argc;) {
+        int end = i + 1;
+        while (end < argc && std::string(argv[end]) != "--tee") {
+            ++end;
         }
+        if (end - i < 2) {
+            throw std::invalid_argument("Missing output file for --tee option");
+        }
+
+        OutputSpec spec;
+        spec.FileName = argv[end - 1];
+        for (int j = i + 1; j < end - 1; ++j) {
+            std::string option = argv[j];
+            if (option == "--compress") {
+                spec.Stages.AddStage({StageKind::Compress});
+            } else if (option == "--sparse") {
+                spec.Sparse = true;
+            } else if (option == "--encrypt") {
+                if (j + 1 >= end - 1) {
+                    throw std::invalid_argument("Missing key for --encrypt option");
+                }
+                j++;
+                spec.Stages.AddStage({StageKind::Encrypt, ParseKey(option, argv[j])});
+            } else {
+                throw std::invalid_argument("Invalid option for --tee output: " + option);
+            }
+        }
+        outputs.push_back(std::move(spec));
+        i = end;
     }
+    return outputs;
 }
 
 int main(int argc, char** argv)
 
 {
-    if (argc < 3) {
+    // Основные аргументы заканчиваются на первой группе --tee
+    int primaryEnd = 1;
+    while (primaryEnd < argc && std::string(argv[primaryEnd]) != "--tee") {
+        ++primaryEnd;
+    }
+
+    if (primaryEnd < 3) {
         std::cerr << "Wrong input parameters" << std::endl;
         std::cerr << "Invalid arguments. Usage:" << std::endl;
-        std::cerr << "  " << argv[0] << " [options] <input-file> <output-file>" << std::endl;
+        std::cerr << "  " << argv[0]
+                  << " [options] <input-file> <output-file> [--tee [options] <output-file>]..."
+                  << std::endl;
         return 1;
     }
 
     try {
-        std::string inputFile = argv[argc - 2];
-        std::string outputFile = argv[argc - 1];
+        std::string inputFile = argv[primaryEnd - 2];
+        std::string outputFile = argv[primaryEnd - 1];
 
-        IInputPtr inputStream = std::make_unique<FileInputStream>(inputFile);
-        IOutputPtr outputStream = std::make_unique<FileOutputStream>(outputFile);
+        std::size_t blockSize = DefaultBlockSize;
+        bool autoBlockSize = false;
+        bool prefetch = false;
+        bool sparse = false;
+        bool teeThreads = false;
+        bool incremental = false;
+        std::size_t chunkSize = DefaultChunkSize;
+        unsigned jobs = 1;
+        Pipeline pipeline;
 
-        // "Оборачиваем" потоки декораторами в соответствии с опциями в порядке передачи параметров
-        for (int i = 1; i < argc - 2; ++i) {
+        // Собираем цепочку декораторов в соответствии с опциями в порядке передачи параметров
+        for (int i = 1; i < primaryEnd - 2; ++i) {
             std::string option = argv[i];
 
-            if (option == "--compress") {
-                outputStream = std::make_unique<CompressingOutputStream>(std::move(outputStream));
+            if (option == "--prefetch") {
+                prefetch = true;
+            } else if (option == "--sparse") {
+                sparse = true;
+            } else if (option == "--tee-threads") {
+                teeThreads = true;
+            } else if (option == "--keyring") {
+                if (i + 1 >= primaryEnd - 2) {
+                    throw std::invalid_argument("Missing value for --keyring option");
+                }
+                i++;
+                SubstitutionTableRegistry::Instance().Preload(ParseKeyring(argv[i]));
+            } else if (option == "--incremental") {
+                incremental = true;
+            } else if (option == "--chunk-size") {
+                if (i + 1 >= primaryEnd - 2) {
+                    throw std::invalid_argument("Missing value for --chunk-size option");
+                }
+                i++;
+                chunkSize = ParseSize(option, argv[i], MaxChunkSize);
+            } else if (option == "--jobs") {
+                if (i + 1 >= primaryEnd - 2) {
+                    throw std::invalid_argument("Missing value for --jobs option");
+                }
+                i++;
+                jobs = static_cast<unsigned>(ParseSize(option, argv[i], MaxJobs));
+            } else if (option == "--block-size") {
+                if (i + 1 >= primaryEnd - 2) {
+                    throw std::invalid_argument("Missing value for --block-size option");
+                }
+                i++;
+                std::string value = argv[i];
+                if (value == "auto") {
+                    autoBlockSize = true;
+                    continue;
+                }
+                blockSize = ParseSize(option, value, MaxBlockSize);
+                autoBlockSize = false;
+            } else if (option == "--compress") {
+                pipeline.AddStage({StageKind::Compress});
             } else if (option == "--decompress") {
-                inputStream = std::make_unique<DecompressingInputStream>(std::move(inputStream));
+                pipeline.AddStage({StageKind::Decompress});
             } else if (option == "--encrypt") {
-                if (i + 1 >= argc - 2) {
+                if (i + 1 >= primaryEnd - 2) {
                     throw std::invalid_argument("Missing key for --encrypt option");
                 }
                 i++;  // Переходим к аргументу с ключом
-                try {
-                    uint32_t key = (uint32_t)std::stoul(argv[i]);
-                    outputStream =
-                        std::make_unique<EncryptingOutputStream>(std::move(outputStream), key);
-                } catch (const std::exception&) {
-                    throw std::invalid_argument("Invalid key for --encrypt option: " +
-                                                std::string(argv[i]));
-                }
+                pipeline.AddStage({StageKind::Encrypt, ParseKey(option, argv[i])});
             } else if (option == "--decrypt") {
-                if (i + 1 >= argc - 2) {
+                if (i + 1 >= primaryEnd - 2) {
                     throw std::invalid_argument("Missing key for --decrypt option");
                 }
                 i++;  // Переходим к аргументу с ключом
-                try {
-                    uint32_t key = (uint32_t)std::stoul(argv[i]);
-                    inputStream =
-                        std::make_unique<DecryptingInputStream>(std::move(inputStream), key);
-                } catch (const std::exception&) {
-                    throw std::invalid_argument("Invalid key for --decrypt option: " +
-                                                std::string(argv[i]));
-                }
+                pipeline.AddStage({StageKind::Decrypt, ParseKey(option, argv[i])});
             } else {
                 throw std::invalid_argument("Invalid option: " + option);
             }
+        }
+
+        const std::vector<OutputSpec> teeOutputs = ParseTeeOutputs(primaryEnd, argc, argv);
+
+        if (incremental && teeOutputs.empty() == false) {
+            throw std::invalid_argument("--incremental cannot be combined with --tee");
+        }
+        if (teeThreads && teeOutputs.empty()) {
+            throw std::invalid_argument("--tee-threads requires at least one --tee output");
+        }
+
+        // Цепочку без состояния можно обработать независимыми диапазонами в нескольких потоках.
+        // Каналы и устройства на входе или выходе обрабатываются последовательно
+        if (jobs > 1 && pipeline.IsStateless() && teeOutputs.empty() && !incremental &&
+            IsRegularFile(inputFile) && IsRegularOrMissingFile(outputFile)) {
+            ParallelTransform(inputFile, outputFile, pipeline, jobs, blockSize, sparse);
+            return 0;
+        }
+
+        IInputPtr inputStream;
+        if (prefetch) {
+            inputStream = std::make_unique<PrefetchingFileInputStream>(inputFile);
+        } else {
+            inputStream = std::make_unique<FileInputStream>(inputFile);
+        }
+        inputStream = pipeline.WrapInput(std::move(inputStream));
+
+        // Повторно обрабатываем только изменившиеся блоки, остальные берем из прежнего результата
+        if (incremental) {
+            const IncrementalStats stats =
+                IncrementalTransform(*inputStream, outputFile, pipeline, chunkSize, sparse);
+            std::clog << "Chunks reused: " << stats.ReusedChunks
+                      << ", processed: " << stats.ProcessedChunks << std::endl;
+            return 0;
+        }
+
+        IOutputPtr outputStream =
+            pipeline.WrapOutput(std::make_unique<FileOutputStream>(outputFile, sparse));
+
+        // Входные данные читаются один раз и раздаются всем выходам
+        if (teeOutputs.empty() == false) {
+            std::vector<IOutputPtr> outputs;
+            outputs.push_back(std::move(outputStream));
+            for (const OutputSpec& spec : teeOutputs) {
+                outputs.push_back(spec.Stages.WrapOutput(
+                    std::make_unique<FileOutputStream>(spec.FileName, spec.Sparse)));
+            }
+            outputStream = std::make_unique<TeeOutputStream>(std::move(outputs), teeThreads);
+        }
 
-            // Using the constracted decorator for input and output stream
-            TransformData(*inputStream, *outputStream);
+        // Using the constracted decorator for input and output stream
+        if (autoBlockSize) {
+            BlockSizeTuner tuner;
+            TransformData(*inputStream, *outputStream, tuner);
+            // На коротких входных данных пробы не успевают завершиться
+            if (tuner.IsSettled() == true) {
+                std::clog << "Block size: " << tuner.GetBlockSize() << std::endl;
+            } else {
+                std::clog << "Block size: tuning did not finish, input is too short" << std::endl;
+            }
+        } else {
+            TransformData(*inputStream, *outputStream, blockSize);
         }
+        // Закрываем явно, чтобы ошибки записи (в том числе в ветвях --tee) не терялись
+        outputStream->Close();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
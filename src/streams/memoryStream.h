@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "IStream.h"
+
+/**
+ * @brief Поток ввода, читающий данные из вектора в памяти.
+ */
+class MemoryInputStream : public IInputDataStream {
+   public:
+    explicit MemoryInputStream(std::vector<uint8_t> data) : _Data(std::move(data)) {}
+
+    /**
+     *  @brief  Возвращает признак достижения конца данных потока.
+     *  @throw  std::logic_error, если поток был закрыт
+     */
+    bool IsEOF() const override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        return _Position >= _Data.size();
+    }
+
+    /**
+     *  @brief  Считывает байт из потока.
+     *  @throw  std::ios_base::failure при попытке чтения за концом данных или
+     * std::logic_error, если поток был закрыт
+     */
+    uint8_t ReadByte() override {
+        if (IsEOF() == true) {
+            throw std::ios_base::failure("Read past end of data");
+        }
+        return _Data[_Position++];
+    }
+
+    /**
+     *  @brief  Считывает из потока блок данных размером не более size байт.
+     *  @throw  std::logic_error, если поток был закрыт
+     *  @return Возвращает количество реально прочитанных байт.
+     */
+    std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        const std::size_t readSize =
+            std::min(_Data.size() - _Position, static_cast<std::size_t>(size));
+        std::memcpy(dstBuffer, _Data.data() + _Position, readSize);
+        _Position += readSize;
+        return static_cast<std::streamsize>(readSize);
+    }
+
+    void Close() override { _IsClosed = true; }
+
+   private:
+    std::vector<uint8_t> _Data;
+    std::size_t _Position = 0;
+    bool _IsClosed = false;
+};
+
+/**
+ * @brief Поток вывода, накапливающий данные в векторе в памяти.
+ *
+ * Данные остаются доступными через GetData() и после закрытия потока.
+ */
+class MemoryOutputStream : public IOutputDataStream {
+   public:
+    /**
+     *  @brief  Записывает в поток данных байт
+     *  @throw  std::logic_error, если поток был закрыт
+     */
+    void WriteByte(uint8_t data) override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        _Data.push_back(data);
+    }
+
+    /**
+     *  @brief Записывает в поток блок данных размером size байт, располагающийся по адресу srcData
+     *  @throw std::logic_error, если поток был закрыт
+     */
+    void WriteBlock(const void* srcData, std::streamsize size) override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        const auto* data = static_cast<const uint8_t*>(srcData);
+        _Data.insert(_Data.end(), data, data + size);
+    }
+
+    void Close() override { _IsClosed = true; }
+
+    const std::vector<uint8_t>& GetData() const { return _Data; }
+
+    // Очищает накопленные данные, сохраняя выделенную память
+    void Clear() { _Data.clear(); }
+
+   private:
+    std::vector<uint8_t> _Data;
+    bool _IsClosed = false;
+};
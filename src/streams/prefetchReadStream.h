@@ -0,0 +1,405 @@
+#pragma once
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IStream.h"
+
+/**
+ * @brief Файловый поток ввода с упреждающим чтением в отдельном потоке.
+ *
+ * Фоновый поток заполняет кольцо из нескольких крупных буферов, опережая потребителя.
+ * Чтение обслуживается из уже готовых буферов, поэтому вычисления в декораторах идут
+ * параллельно с ожиданием диска. Ядру сообщается о последовательном доступе
+ * (POSIX_FADV_SEQUENTIAL/WILLNEED), а уже прочитанные диапазоны освобождаются из
+ * страничного кэша (POSIX_FADV_DONTNEED). Дыры разреженных файлов находятся через
+ * SEEK_DATA/SEEK_HOLE и заполняются нулями без чтения. Каналы и другие источники без
+ * произвольного доступа читаются последовательно через read() без подсказок ядру; фоновый
+ * поток ждет их данных через poll() и отдает буфер, не дожидаясь его заполнения.
+ */
+class PrefetchingFileInputStream : public IInputDataStream {
+   public:
+    static constexpr std::size_t DefaultBufferSize = 1 << 20;
+    static constexpr std::size_t DefaultBufferCount = 4;
+
+    /**
+     *  @brief  Конструктор, открывающий файл и запускающий поток упреждающего чтения.
+     *  @param  bufferSize Размер одного буфера кольца в байтах.
+     *  @param  bufferCount Количество буферов в кольце (не меньше двух).
+     *  @throw  В случае ошибки открытия файла выбрасывает исключение std::ios_base::failure
+     */
+    explicit PrefetchingFileInputStream(const std::string& fileName,
+                                        std::size_t bufferSize = DefaultBufferSize,
+                                        std::size_t bufferCount = DefaultBufferCount) {
+        if (bufferSize == 0 || bufferCount < 2) {
+            throw std::invalid_argument("Invalid prefetch buffer configuration");
+        }
+
+        _Fd = ::open(fileName.c_str(), O_RDONLY);
+        if (_Fd < 0) {
+            throw std::ios_base::failure("Failed to open file!");
+        }
+        // Деструктор не вызывается для недостроенного объекта, поэтому до конца конструктора
+        // дескриптор закрывает страж
+        auto closeFd = [](int* fd) {
+            if (*fd >= 0) {
+                ::close(*fd);
+            }
+        };
+        std::unique_ptr<int, void (*)(int*)> fdGuard{&_Fd, closeFd};
+        std::unique_ptr<int, void (*)(int*)> wakeGuard{&_WakeFd, closeFd};
+
+        // pread, подсказки ядру и поиск дыр доступны только для обычных файлов
+        struct stat info {};
+        _IsRegular = ::fstat(_Fd, &info) == 0 && S_ISREG(info.st_mode);
+        _SkipHoles = _IsRegular;
+
+        // Чтение из канала может ждать сколь угодно долго, поэтому фоновый поток ждет данных
+        // через poll() вместе с дескриптором пробуждения, который сигнализирует Close()
+        if (_IsRegular == false) {
+            const int flags = ::fcntl(_Fd, F_GETFL);
+            _WakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (flags < 0 || ::fcntl(_Fd, F_SETFL, flags | O_NONBLOCK) < 0 || _WakeFd < 0) {
+                throw std::ios_base::failure("Failed to prepare input: " +
+                                             std::string(std::strerror(errno)));
+            }
+        }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (_IsRegular == true) {
+            ::posix_fadvise(_Fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            ::posix_fadvise(_Fd, 0, static_cast<off_t>(bufferSize * bufferCount),
+                            POSIX_FADV_WILLNEED);
+        }
+#endif
+
+        _Buffers.resize(bufferCount);
+        for (auto& buffer : _Buffers) {
+            buffer.Data = std::make_unique<char[]>(bufferSize);
+        }
+        _BufferSize = bufferSize;
+
+        _Reader = std::thread(&PrefetchingFileInputStream::ReaderLoop, this);
+        fdGuard.release();
+        wakeGuard.release();
+    }
+
+    /**
+     *  @brief  Возвращает признак достижения конца данных потока. Пока в текущем буфере есть
+     * данные, это простая проверка флагов; ожидание возможно только на границе буферов.
+     *  @throw  Выбрасывает исключение std::ios_base::failure в случае ошибки чтения или
+     * std::logic_error, если поток был закрыт
+     *  @return true/false достижения конца файла
+     */
+    bool IsEOF() const override {
+        if (_IsClosed == true) {
+            throw std::logic_error("Stream is closed");
+        }
+        if (_AtEOF == true) {
+            return true;
+        }
+        if (_HasCurrent == true && _ReadPos < _Buffers[_ReadIndex].Size) {
+            return false;
+        }
+        return AcquireBuffer() == false;
+    }
+
+    /**
+     *  @brief  Считывает байт из потока.
+     *  @throw  Выбрасывает исключение std::ios_base::failure в случае ошибки чтения или попытки
+     * чтения за концом файла, std::logic_error, если поток был закрыт
+     *  @return Один прочитанный байт из потока
+     */
+    uint8_t ReadByte() override {
+        if (IsEOF() == true) {
+            throw std::ios_base::failure("Read past end of file");
+        }
+        return static_cast<uint8_t>(_Buffers[_ReadIndex].Data[_ReadPos++]);
+    }
+
+    /**
+     *  @brief  Считывает из потока блок данных размером size байт, записывая его в память по адресу
+     * dstBuffer
+     *  @throw  Выбрасывает исключение std::ios_base::failure в случае ошибки чтения или
+     * std::logic_error, если поток был закрыт
+     *  @return Возвращает количество реально прочитанных байт.
+     */
+    std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override {
+        auto* dst = static_cast<char*>(dstBuffer);
+        std::streamsize readSize = 0;
+
+        while (readSize < size && IsEOF() == false) {
+            const Buffer& current = _Buffers[_ReadIndex];
+            const std::size_t chunk =
+                std::min(current.Size - _ReadPos, static_cast<std::size_t>(size - readSize));
+            std::memcpy(dst + readSize, current.Data.get() + _ReadPos, chunk);
+            _ReadPos += chunk;
+            readSize += static_cast<std::streamsize>(chunk);
+        }
+        return readSize;
+    }
+
+    /**
+     *  @brief  Закрывает поток, останавливая поток упреждающего чтения. Операции над ним после
+     * этого должны выбрасывать исключение logic_error
+     */
+    void Close() override {
+        if (_IsClosed == false) {
+            {
+                std::lock_guard lock(_Mutex);
+                _Stop = true;
+            }
+            _CanWrite.notify_all();
+            if (_WakeFd >= 0) {
+                const uint64_t signal = 1;
+                [[maybe_unused]] const ssize_t result = ::write(_WakeFd, &signal, sizeof(signal));
+            }
+            if (_Reader.joinable()) {
+                _Reader.join();
+            }
+            ::close(_Fd);
+            if (_WakeFd >= 0) {
+                ::close(_WakeFd);
+            }
+            _IsClosed = true;
+        }
+    }
+
+    /**
+     * @brief Деструктор, гарантирующий закрытие потока.
+     */
+    ~PrefetchingFileInputStream() override { Close(); }
+
+   private:
+    struct Buffer {
+        std::unique_ptr<char[]> Data;
+        std::size_t Size = 0;
+        off_t Offset = 0;
+    };
+
+    // Переходит к следующему готовому буферу, возвращая текущий фоновому потоку.
+    // Возвращает false, если данных больше нет.
+    bool AcquireBuffer() const {
+        if (_HasCurrent == true) {
+            ReleaseBuffer();
+        }
+
+        std::unique_lock lock(_Mutex);
+        _CanRead.wait(lock, [this] { return _ReadyCount > 0 || _ReaderDone; });
+
+        if (_ReadyCount > 0) {
+            _HasCurrent = true;
+            _ReadPos = 0;
+            return true;
+        }
+        if (_Error) {
+            std::rethrow_exception(_Error);
+        }
+        _AtEOF = true;
+        return false;
+    }
+
+    void ReleaseBuffer() const {
+#ifdef POSIX_FADV_DONTNEED
+        if (_IsRegular == true) {
+            const Buffer& consumed = _Buffers[_ReadIndex];
+            ::posix_fadvise(_Fd, consumed.Offset, static_cast<off_t>(consumed.Size),
+                            POSIX_FADV_DONTNEED);
+        }
+#endif
+        _ReadIndex = (_ReadIndex + 1) % _Buffers.size();
+        _HasCurrent = false;
+        {
+            std::lock_guard lock(_Mutex);
+            --_ReadyCount;
+        }
+        _CanWrite.notify_one();
+    }
+
+    void ReaderLoop() {
+        std::size_t writeIndex = 0;
+        off_t offset = 0;
+
+        try {
+            while (true) {
+                {
+                    std::unique_lock lock(_Mutex);
+                    _CanWrite.wait(lock, [this] { return _Stop || _ReadyCount < _Buffers.size(); });
+                    if (_Stop) {
+                        break;
+                    }
+                }
+
+                Buffer& buffer = _Buffers[writeIndex];
+                const std::size_t size = FillBuffer(buffer.Data.get(), offset);
+                if (size == 0) {
+                    break;
+                }
+#ifdef POSIX_FADV_WILLNEED
+                if (_IsRegular == true) {
+                    const off_t ahead = static_cast<off_t>(_BufferSize * _Buffers.size());
+                    ::posix_fadvise(_Fd, offset + ahead, static_cast<off_t>(_BufferSize),
+                                    POSIX_FADV_WILLNEED);
+                }
+#endif
+                buffer.Size = size;
+                buffer.Offset = offset;
+                offset += static_cast<off_t>(size);
+                writeIndex = (writeIndex + 1) % _Buffers.size();
+
+                {
+                    std::lock_guard lock(_Mutex);
+                    ++_ReadyCount;
+                }
+                _CanRead.notify_one();
+            }
+        } catch (...) {
+            std::lock_guard lock(_Mutex);
+            _Error = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(_Mutex);
+            _ReaderDone = true;
+        }
+        _CanRead.notify_one();
+    }
+
+    // Читает в буфер до его заполнения или конца файла, возвращает количество прочитанных байт.
+    // Дыры разреженного файла заполняются нулями без обращения к диску. Из канала возвращает
+    // уже пришедшие данные, не дожидаясь заполнения буфера, и 0 при закрытии потока.
+    std::size_t FillBuffer(char* data, off_t offset) {
+        std::size_t filled = 0;
+        while (filled < _BufferSize) {
+            const off_t position = offset + static_cast<off_t>(filled);
+            std::size_t want = _BufferSize - filled;
+
+            if (_SkipHoles == true) {
+                if (position >= _RegionEnd) {
+                    UpdateRegion(position);
+                }
+                if (_SkipHoles == true) {
+                    want = static_cast<std::size_t>(
+                        std::min(static_cast<off_t>(want), _RegionEnd - position));
+                    if (_RegionIsHole == true) {
+                        std::memset(data + filled, 0, want);
+                        filled += want;
+                        continue;
+                    }
+                }
+            }
+
+            const ssize_t result = _IsRegular == true
+                                       ? ::pread(_Fd, data + filled, want, position)
+                                       : ::read(_Fd, data + filled, want);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    if (filled > 0 || WaitReadable() == false) {
+                        break;
+                    }
+                    continue;
+                }
+                throw std::ios_base::failure("Failed to read file: " +
+                                             std::string(std::strerror(errno)));
+            }
+            if (result == 0) {
+                break;
+            }
+            filled += static_cast<std::size_t>(result);
+        }
+        return filled;
+    }
+
+    // Ожидает данных во входном дескрипторе. Возвращает false, если поток закрывается.
+    bool WaitReadable() {
+        pollfd fds[2] = {{_Fd, POLLIN, 0}, {_WakeFd, POLLIN, 0}};
+        while (::poll(fds, 2, -1) < 0) {
+            if (errno != EINTR) {
+                throw std::ios_base::failure("Failed to wait for input: " +
+                                             std::string(std::strerror(errno)));
+            }
+        }
+        return fds[1].revents == 0;
+    }
+
+    // Определяет участок (данные или дыра), в который попадает position, через SEEK_DATA/SEEK_HOLE.
+    // Если файловая система их не поддерживает, пропуск дыр отключается.
+    void UpdateRegion(off_t position) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        const off_t dataStart = ::lseek(_Fd, position, SEEK_DATA);
+        if (dataStart < 0) {
+            struct stat info {};
+            if (errno != ENXIO || ::fstat(_Fd, &info) != 0 || position >= info.st_size) {
+                // Конец файла или отсутствие поддержки: дальше читаем обычным образом
+                _SkipHoles = false;
+                return;
+            }
+            // Дыра до самого конца файла
+            _RegionIsHole = true;
+            _RegionEnd = info.st_size;
+            return;
+        }
+        if (dataStart > position) {
+            _RegionIsHole = true;
+            _RegionEnd = dataStart;
+            return;
+        }
+        const off_t holeStart = ::lseek(_Fd, position, SEEK_HOLE);
+        if (holeStart <= position) {
+            _SkipHoles = false;
+            return;
+        }
+        _RegionIsHole = false;
+        _RegionEnd = holeStart;
+#else
+        (void)position;
+        _SkipHoles = false;
+#endif
+    }
+
+    int _Fd = -1;
+    int _WakeFd = -1;
+    bool _IsRegular = false;
+    std::size_t _BufferSize = 0;
+
+    // Текущий участок файла, известный фоновому потоку
+    bool _SkipHoles = false;
+    bool _RegionIsHole = false;
+    off_t _RegionEnd = 0;
+
+    std::vector<Buffer> _Buffers;
+    std::thread _Reader;
+
+    // Состояние, разделяемое с фоновым потоком, защищено _Mutex.
+    mutable std::mutex _Mutex;
+    mutable std::condition_variable _CanRead;
+    mutable std::condition_variable _CanWrite;
+    mutable std::size_t _ReadyCount = 0;
+    bool _ReaderDone = false;
+    bool _Stop = false;
+    std::exception_ptr _Error;
+
+    // Состояние потребителя.
+    mutable std::size_t _ReadIndex = 0;
+    mutable std::size_t _ReadPos = 0;
+    mutable bool _HasCurrent = false;
+    mutable bool _AtEOF = false;
+    bool _IsClosed = false;
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <string>
 
@@ -6,17 +8,30 @@
 
 class FileOutputStream : public IOutputDataStream {
    public:
+    // Гранулярность поиска нулевых участков в разреженном режиме
+    static constexpr std::streamsize SparseBlockSize = 4096;
+
     /**
      *  @brief  Конструктор, открывающий файл.
+     *  @param  sparse В разреженном режиме выровненные блоки из одних нулей не записываются,
+     * а пропускаются перемещением позиции записи, так что на диске на их месте остаются "дыры".
+     * Если позицию записи перемещать нельзя (канал, терминал), нули записываются обычным образом.
      *  @throw  В случае ошибки открытия файла выбрасывает исключение std::ios_base::failure
      */
-    explicit FileOutputStream(const std::string& fileName) {
+    explicit FileOutputStream(const std::string& fileName, bool sparse = false)
+        : _IsSparse(sparse) {
         _FileStream.open(fileName, std::ios::binary);
 
         if (_FileStream.is_open() == false) {
             throw std::ios_base::failure("Failed to open file!");
         }
 
+        // Без перемещения позиции записи (канал, терминал) дыры оставлять нельзя
+        const auto position = _FileStream.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::out);
+        if (position == std::streampos(-1)) {
+            _IsSparse = false;
+        }
+
         _FileStream.exceptions(std::ofstream::badbit | std::ofstream::failbit);
     }
 
@@ -29,6 +44,10 @@ class FileOutputStream : public IOutputDataStream {
         if (_IsClosed == true) {
             throw std::logic_error("Stream is closed");
         }
+        if (_IsSparse == true) {
+            WriteSparse(reinterpret_cast<const char*>(&data), 1);
+            return;
+        }
         _FileStream.put(data);
     }
 
@@ -41,6 +60,10 @@ class FileOutputStream : public IOutputDataStream {
         if (_IsClosed == true) {
             throw std::logic_error("Stream is closed");
         }
+        if (_IsSparse == true) {
+            WriteSparse(static_cast<const char*>(srcData), size);
+            return;
+        }
 
         _FileStream.write(static_cast<const char*>(srcData), size);
     }
@@ -51,6 +74,14 @@ class FileOutputStream : public IOutputDataStream {
      */
     void Close() override {
         if (_IsClosed == false) {
+            // Нули неполного последнего блока дописываем, а дыра в конце файла не меняет его
+            // размер, поэтому в этом случае последний байт записываем явно
+            if (_DeferredZeros > 0) {
+                _FileStream.write(ZeroBlock, _DeferredZeros);
+            } else if (_EndsWithHole == true) {
+                _FileStream.seekp(-1, std::ios::cur);
+                _FileStream.put(0);
+            }
             _FileStream.close();
             _IsClosed = true;
         }
@@ -62,7 +93,53 @@ class FileOutputStream : public IOutputDataStream {
     ~FileOutputStream() override { Close(); };
 
    private:
+    // Записывает данные, пропуская целиком нулевые блоки, выровненные по SparseBlockSize
+    // относительно начала файла. Подряд идущие блоки с данными записываются одним вызовом.
+    // Нули с начала блока откладываются до его завершения, так что блок может быть набран
+    // из нескольких вызовов.
+    void WriteSparse(const char* data, std::streamsize size) {
+        const char* pending = data;
+        const char* end = data + size;
+
+        for (const char* block = data; block < end;) {
+            const std::streamsize toBoundary = SparseBlockSize - _Size % SparseBlockSize;
+            const std::streamsize blockSize = std::min<std::streamsize>(toBoundary, end - block);
+
+            if (_DeferredZeros == _Size % SparseBlockSize && IsZero(block, blockSize)) {
+                _FileStream.write(pending, block - pending);
+                pending = block + blockSize;
+                _DeferredZeros += blockSize;
+                if (_DeferredZeros == SparseBlockSize) {
+                    _FileStream.seekp(SparseBlockSize, std::ios::cur);
+                    _DeferredZeros = 0;
+                    _EndsWithHole = true;
+                }
+            } else {
+                // В блоке появились данные: отложенные нули нужно записать перед ними
+                if (_DeferredZeros > 0) {
+                    _FileStream.write(ZeroBlock, _DeferredZeros);
+                    _DeferredZeros = 0;
+                }
+                _EndsWithHole = false;
+            }
+
+            block += blockSize;
+            _Size += blockSize;
+        }
+        _FileStream.write(pending, end - pending);
+    }
+
+    static bool IsZero(const char* data, std::streamsize size) {
+        return std::memcmp(data, ZeroBlock, static_cast<std::size_t>(size)) == 0;
+    }
+
+    static constexpr char ZeroBlock[SparseBlockSize] = {};
+
     std::ofstream _FileStream;
 
+    bool _IsSparse = false;
+    bool _EndsWithHole = false;
+    std::streamsize _DeferredZeros = 0;
+    std::streamsize _Size = 0;
     bool _IsClosed = false;
 };
\ No newline at end of file
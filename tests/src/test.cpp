@@ -1,9 +1,28 @@
 #include <gtest/gtest.h>
 
-#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
+#include <thread>
+
+#include "Async/asyncStream.h"
 #include "Compress/compresStream.h"
 #include "Crypto/cryptoStream.h"
+#include "Crypto/substitutionTables.h"
+#include "Tee/teeStream.h"
+#include "Transform/incrementalTransform.h"
+#include "Transform/parallelTransform.h"
+#include "Transform/pipeline.h"
+#include "Transform/transform.h"
+#include "streams/memoryStream.h"
+#include "streams/prefetchReadStream.h"
 #include "streams/readStream.h"
 #include "streams/writeStream.h"
 
@@ -57,6 +76,132 @@ TEST(StreamIntegrationTest, WriteThenReadByteByByte) {
     std::remove(tempFile.c_str());
 }
 
+TEST(PrefetchStreamIntegrationTest, ReadBlockAcrossBuffers) {
+    const std::string tempFile{"temp_prefetch_test_block.bin"};
+    const std::string testData{"Hello, world! This is a test string"};
+
+    {
+        FileOutputStream output{tempFile};
+        output.WriteBlock(testData.c_str(), testData.size());
+    }
+
+    // Маленькие буферы заставляют фоновый поток многократно переиспользовать кольцо
+    std::string readData;
+    {
+        PrefetchingFileInputStream input{tempFile, 4, 2};
+        char buffer[5];
+        while (!input.IsEOF()) {
+            std::streamsize readSize = input.ReadBlock(buffer, sizeof(buffer));
+            readData.append(buffer, readSize);
+        }
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(tempFile.c_str());
+}
+
+TEST(PrefetchStreamIntegrationTest, ReadByteByByte) {
+    const std::string tempFile{"temp_prefetch_test_byte.bin"};
+    const std::string testData{"Hello, world! This is a test string"};
+
+    {
+        FileOutputStream output{tempFile};
+        output.WriteBlock(testData.c_str(), testData.size());
+    }
+
+    std::string readData;
+    {
+        PrefetchingFileInputStream input{tempFile, 3, 3};
+        while (!input.IsEOF()) {
+            readData += input.ReadByte();
+        }
+        ASSERT_THROW(input.ReadByte(), std::ios_base::failure);
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(tempFile.c_str());
+}
+
+TEST(PrefetchStreamIntegrationTest, ReadsFromPipe) {
+    std::string testData;
+    for (int i = 0; i < 10000; ++i) {
+        testData += "pipe data " + std::to_string(i) + "\n";
+    }
+
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    std::thread writer([&testData, fd = fds[1]] {
+        std::size_t written = 0;
+        while (written < testData.size()) {
+            const ssize_t result =
+                ::write(fd, testData.data() + written, testData.size() - written);
+            if (result <= 0) {
+                break;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+        ::close(fd);
+    });
+
+    // Канал не поддерживает pread, поток должен читать его последовательно
+    std::string readData;
+    {
+        PrefetchingFileInputStream input{"/dev/fd/" + std::to_string(fds[0]), 4096, 2};
+        char buffer[1000];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+    }
+    writer.join();
+    ::close(fds[0]);
+
+    ASSERT_EQ(testData, readData);
+}
+
+TEST(PrefetchStreamIntegrationTest, CloseDoesNotWaitForIdlePipe) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    ASSERT_EQ(5, ::write(fds[1], "hello", 5));
+
+    // Писатель не закрывает канал: уже пришедшие данные должны быть доступны сразу,
+    // а закрытие потока не должно ждать новых данных
+    auto done = std::async(std::launch::async, [fd = fds[0]] {
+        PrefetchingFileInputStream input{"/dev/fd/" + std::to_string(fd), 4096, 2};
+        char buffer[5];
+        return std::string(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+    });
+
+    const bool finished = done.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    ::close(fds[1]);
+    ASSERT_TRUE(finished);
+    ASSERT_EQ("hello", done.get());
+    ::close(fds[0]);
+}
+
+TEST(PrefetchStreamIntegrationTest, ThrowsOnNonExistentFile) {
+    ASSERT_THROW(PrefetchingFileInputStream("non_existent_file_12345.tmp"),
+                 std::ios_base::failure);
+}
+
+// Проверяем, что операции чтения бросают std::logic_error после остановки фонового потока
+TEST(PrefetchStreamIntegrationTest, ThrowsAfterClose) {
+    const std::string tempFile = "test_for_close_prefetch.tmp";
+    {
+        FileOutputStream output{tempFile};
+        output.WriteByte(1);
+    }
+
+    PrefetchingFileInputStream input{tempFile};
+    input.Close();
+
+    ASSERT_THROW(input.IsEOF(), std::logic_error);
+    ASSERT_THROW(input.ReadByte(), std::logic_error);
+    char buffer;
+    ASSERT_THROW(input.ReadBlock(&buffer, 1), std::logic_error);
+
+    std::remove(tempFile.c_str());
+}
+
 TEST(StreamExceptionTest, InputThrowsOnNonExistentFile) {
     // Проверяем, что конструктор FileInputStream бросает исключение,
     // если файл не существует.
@@ -232,3 +377,617 @@ TEST(CompressStreamIntegrationTest, WorstCaseScenario) {
     ASSERT_EQ(testData, readData);
     std::remove(tempFile.c_str());
 }
+
+TEST(BlockSizeTunerTest, SettlesOnFastestCandidate) {
+    BlockSizeTuner tuner{{1024, 2048, 4096}, 4096};
+    // Пропускная способность (байт за микросекунду) для каждого кандидата
+    const std::map<std::size_t, int> speed{{1024, 1}, {2048, 4}, {4096, 2}};
+
+    while (!tuner.IsSettled()) {
+        const std::size_t size = tuner.GetBlockSize();
+        tuner.Record(size, std::chrono::microseconds(size / speed.at(size)));
+    }
+
+    ASSERT_EQ(2048u, tuner.GetBlockSize());
+}
+
+TEST(BlockSizeTunerTest, ShortInputDoesNotSettle) {
+    BlockSizeTuner tuner{{1024, 2048, 4096}, 4096};
+    // Данных меньше, чем нужно для проб всех кандидатов
+    tuner.Record(4096, std::chrono::microseconds(4096));
+    tuner.Record(1000, std::chrono::microseconds(1000));
+
+    ASSERT_FALSE(tuner.IsSettled());
+}
+
+TEST(BlockSizeTunerTest, ReprobesWhenThroughputDrifts) {
+    BlockSizeTuner tuner{{1024, 2048}, 2048, 0.5};
+    while (!tuner.IsSettled()) {
+        tuner.Record(tuner.GetBlockSize(), std::chrono::microseconds(tuner.GetBlockSize()));
+    }
+
+    // Пропускная способность упала в 10 раз - после окна наблюдения пробы начинаются заново
+    for (int i = 0; i < 4 && tuner.IsSettled(); ++i) {
+        tuner.Record(tuner.GetBlockSize(), std::chrono::microseconds(tuner.GetBlockSize() * 10));
+    }
+
+    ASSERT_FALSE(tuner.IsSettled());
+}
+
+TEST(TransformDataTest, AutoBlockSizeCopiesAllData) {
+    const std::string inputFile{"temp_transform_auto_in.bin"};
+    const std::string outputFile{"temp_transform_auto_out.bin"};
+    std::string testData;
+    for (int i = 0; i < 1000; ++i) {
+        testData += "block size tuning " + std::to_string(i);
+    }
+
+    {
+        FileOutputStream output{inputFile};
+        output.WriteBlock(testData.c_str(), testData.size());
+    }
+
+    {
+        FileInputStream input{inputFile};
+        FileOutputStream output{outputFile};
+        BlockSizeTuner tuner{{7, 64, 1000}, 512};
+        TransformData(input, output, tuner);
+        ASSERT_TRUE(tuner.IsSettled());
+    }
+
+    std::string readData;
+    {
+        FileInputStream input{outputFile};
+        std::vector<char> buffer(testData.size());
+        readData.assign(buffer.data(), input.ReadBlock(buffer.data(), buffer.size()));
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(inputFile.c_str());
+    std::remove(outputFile.c_str());
+}
+
+TEST(PipelineTest, DetectsStatelessStages) {
+    Pipeline crypto;
+    crypto.AddStage({StageKind::Decrypt, 3});
+    crypto.AddStage({StageKind::Encrypt, 100500});
+    ASSERT_TRUE(crypto.IsStateless());
+
+    Pipeline compress;
+    compress.AddStage({StageKind::Encrypt, 3});
+    compress.AddStage({StageKind::Compress});
+    ASSERT_FALSE(compress.IsStateless());
+    ASSERT_THROW(compress.ComposeSubstitution(), std::logic_error);
+}
+
+TEST(ParallelTransformTest, MatchesSequentialTransform) {
+    const std::string inputFile{"temp_parallel_in.bin"};
+    const std::string sequentialFile{"temp_parallel_seq.bin"};
+    const std::string parallelFile{"temp_parallel_par.bin"};
+    std::string testData;
+    for (int i = 0; i < 5000; ++i) {
+        testData += static_cast<char>(i * 7 + i / 13);
+    }
+
+    {
+        FileOutputStream output{inputFile};
+        output.WriteBlock(testData.c_str(), testData.size());
+    }
+
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Decrypt, 7});
+    pipeline.AddStage({StageKind::Encrypt, 3});
+    pipeline.AddStage({StageKind::Encrypt, 100500});
+
+    {
+        auto input = pipeline.WrapInput(std::make_unique<FileInputStream>(inputFile));
+        auto output = pipeline.WrapOutput(std::make_unique<FileOutputStream>(sequentialFile));
+        TransformData(*input, *output);
+    }
+    // Маленький блок дает несколько диапазонов и несколько блоков внутри каждого
+    ParallelTransform(inputFile, parallelFile, pipeline, 4, 256);
+
+    auto readAll = [](const std::string& fileName) {
+        FileInputStream input{fileName};
+        std::string data;
+        char buffer[1024];
+        while (!input.IsEOF()) {
+            data.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+        return data;
+    };
+
+    const std::string sequentialData = readAll(sequentialFile);
+    ASSERT_EQ(testData.size(), sequentialData.size());
+    ASSERT_EQ(sequentialData, readAll(parallelFile));
+
+    std::remove(inputFile.c_str());
+    std::remove(sequentialFile.c_str());
+    std::remove(parallelFile.c_str());
+}
+
+TEST(ParallelTransformTest, RejectsPipeInput) {
+    const std::string outputFile{"temp_parallel_pipe.bin"};
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    const std::string testData(1000, 'x');
+    ASSERT_EQ(static_cast<ssize_t>(testData.size()),
+              ::write(fds[1], testData.data(), testData.size()));
+
+    // Размер канала неизвестен: вместо пустого результата должна быть ошибка,
+    // а main должен выбрать последовательную обработку
+    const std::string pipeName = "/dev/fd/" + std::to_string(fds[0]);
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Encrypt, 5});
+    ASSERT_FALSE(IsRegularFile(pipeName));
+    ASSERT_THROW(ParallelTransform(pipeName, outputFile, pipeline, 4), std::ios_base::failure);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::remove(outputFile.c_str());
+}
+
+TEST(ParallelTransformTest, RejectsPipeOutput) {
+    const std::string inputFile{"temp_parallel_pipe_in.bin"};
+    const std::string missingFile{"temp_parallel_missing.bin"};
+    {
+        FileOutputStream output{inputFile};
+        output.WriteBlock("data", 4);
+    }
+
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+
+    // Размер канала нельзя задать через ftruncate: main должен выбрать последовательную
+    // обработку, а ParallelTransform - сообщить об ошибке
+    const std::string pipeName = "/dev/fd/" + std::to_string(fds[1]);
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Encrypt, 5});
+    ASSERT_FALSE(IsRegularOrMissingFile(pipeName));
+    ASSERT_TRUE(IsRegularOrMissingFile(missingFile));
+    ASSERT_TRUE(IsRegularOrMissingFile(inputFile));
+    ASSERT_THROW(ParallelTransform(inputFile, pipeName, pipeline, 4), std::ios_base::failure);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::remove(inputFile.c_str());
+}
+
+// Возвращает true, если в файле есть дыра до его конца
+static bool HasHoles(const std::string& fileName) {
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    const bool result =
+        ::fstat(fd, &info) == 0 && ::lseek(fd, 0, SEEK_HOLE) < static_cast<off_t>(info.st_size);
+    ::close(fd);
+    return result;
+}
+
+TEST(SparseStreamIntegrationTest, ZeroRunsRoundTrip) {
+    const std::string tempFile{"temp_sparse_test.bin"};
+    // Данные, нулевые блоки в середине и нулевой хвост, который должен сохранить размер файла
+    std::string testData = "head";
+    testData.append(32 * FileOutputStream::SparseBlockSize, '\0');
+    testData += "middle";
+    testData.append(2 * FileOutputStream::SparseBlockSize + 17, '\0');
+
+    {
+        FileOutputStream output{tempFile, true};
+        // Пишем неровными порциями, чтобы блоки пересекали границы вызовов
+        for (std::size_t pos = 0; pos < testData.size(); pos += 1000) {
+            output.WriteBlock(testData.data() + pos,
+                              std::min<std::size_t>(1000, testData.size() - pos));
+        }
+    }
+
+    ASSERT_TRUE(HasHoles(tempFile));
+
+    std::string readData;
+    {
+        PrefetchingFileInputStream input{tempFile, 1000, 2};
+        char buffer[777];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(tempFile.c_str());
+}
+
+TEST(SparseStreamIntegrationTest, PipeOutputGetsZeros) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    std::string testData(3 * FileOutputStream::SparseBlockSize, '\0');
+    testData += "tail";
+
+    // Канал не поддерживает перемещение позиции записи: нули должны быть записаны явно.
+    // Данные меньше буфера канала, поэтому запись не блокируется
+    {
+        FileOutputStream output{"/dev/fd/" + std::to_string(fds[1]), true};
+        output.WriteBlock(testData.data(), testData.size());
+    }
+    ::close(fds[1]);
+
+    std::string readData;
+    char buffer[4096];
+    ssize_t result;
+    while ((result = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+        readData.append(buffer, static_cast<std::size_t>(result));
+    }
+    ::close(fds[0]);
+
+    ASSERT_EQ(testData, readData);
+}
+
+TEST(SparseStreamIntegrationTest, ParallelTransformLeavesHoles) {
+    const std::string inputFile{"temp_sparse_parallel_in.bin"};
+    const std::string outputFile{"temp_sparse_parallel_out.bin"};
+    std::string testData = "head";
+    testData.append(32 * FileOutputStream::SparseBlockSize, '\0');
+    testData += "tail";
+
+    {
+        FileOutputStream output{inputFile};
+        output.WriteBlock(testData.data(), testData.size());
+    }
+
+    // Дешифрование тем же ключом после шифрования дает тождественную таблицу, и нули остаются
+    // нулями
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Decrypt, 9});
+    pipeline.AddStage({StageKind::Encrypt, 9});
+    ParallelTransform(inputFile, outputFile, pipeline, 3, 8192, true);
+
+    ASSERT_TRUE(HasHoles(outputFile));
+
+    std::string readData;
+    {
+        FileInputStream input{outputFile};
+        char buffer[4096];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(inputFile.c_str());
+    std::remove(outputFile.c_str());
+}
+
+TEST(CompressStreamIntegrationTest, LongRunsBlock) {
+    const std::string tempFile{"temp_compress_long_runs.bin"};
+    std::string testData(1000, '\0');
+    testData += "AB";
+    testData.append(300, 'C');
+
+    {
+        CompressingOutputStream output{std::make_unique<FileOutputStream>(tempFile)};
+        output.WriteBlock(testData.c_str(), 500);
+        output.WriteBlock(testData.c_str() + 500, testData.size() - 500);
+    }
+
+    std::string readData;
+    {
+        DecompressingInputStream input{std::make_unique<FileInputStream>(tempFile)};
+        char buffer[100];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+    }
+
+    ASSERT_EQ(testData, readData);
+    std::remove(tempFile.c_str());
+}
+
+TEST(MemoryStreamTest, WriteThenRead) {
+    const std::string testData{"Hello, world! This is a test string"};
+
+    MemoryOutputStream output;
+    output.WriteBlock(testData.c_str(), 5);
+    output.WriteBlock(testData.c_str() + 5, testData.size() - 5);
+    output.Close();
+    ASSERT_THROW(output.WriteByte(0), std::logic_error);
+
+    MemoryInputStream input{output.GetData()};
+    std::string readData;
+    while (!input.IsEOF()) {
+        readData += input.ReadByte();
+    }
+    ASSERT_EQ(testData, readData);
+    ASSERT_THROW(input.ReadByte(), std::ios_base::failure);
+}
+
+TEST(AsyncStreamTest, ConcurrentTransformsOverPipes) {
+    constexpr int transformCount = 64;
+    constexpr std::size_t dataSize = 200000;  // больше буфера канала, чтобы запись ожидала чтения
+    const unsigned key = 42;
+
+    std::string testData;
+    for (std::size_t i = 0; i < dataSize; ++i) {
+        testData += static_cast<char>(i / 1000);
+    }
+
+    std::vector<MemoryOutputStream*> sinks;
+    std::vector<std::unique_ptr<IAsyncInputDataStream>> inputs;
+    std::vector<std::unique_ptr<IAsyncOutputDataStream>> outputs;
+    {
+        AsyncExecutor executor{2};
+        for (int i = 0; i < transformCount; ++i) {
+            int fds[2];
+            ASSERT_EQ(0, ::pipe(fds));
+
+            // Источник пишет данные в канал, преобразование читает их с другого конца,
+            // сжимает, шифрует и складывает в память
+            auto writer = std::make_shared<AsyncFdOutputStream>(fds[1], executor);
+            executor.Spawn([](std::shared_ptr<AsyncFdOutputStream> writer,
+                              const std::string& data) -> Task<void> {
+                co_await writer->WriteBlockAsync(data.data(), data.size());
+                co_await writer->CloseAsync();
+            }(writer, testData));
+
+            auto sink = std::make_unique<MemoryOutputStream>();
+            sinks.push_back(sink.get());
+            inputs.push_back(std::make_unique<AsyncFdInputStream>(fds[0], executor));
+            outputs.push_back(std::make_unique<DecoratedAsyncOutputStream>(
+                std::make_unique<SyncOutputAdapter>(std::move(sink)), [key](IOutputPtr stream) {
+                    stream = std::make_unique<EncryptingOutputStream>(std::move(stream), key);
+                    return IOutputPtr{std::make_unique<CompressingOutputStream>(std::move(stream))};
+                }));
+
+            executor.Spawn([](IAsyncInputDataStream& input,
+                              IAsyncOutputDataStream& output) -> Task<void> {
+                co_await TransformDataAsync(input, output, 4096);
+                co_await output.CloseAsync();
+            }(*inputs.back(), *outputs.back()));
+        }
+        executor.Wait();
+    }
+
+    for (MemoryOutputStream* sink : sinks) {
+        DecompressingInputStream input{std::make_unique<DecryptingInputStream>(
+            std::make_unique<MemoryInputStream>(sink->GetData()), key)};
+        std::string readData;
+        char buffer[4096];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+        ASSERT_EQ(testData, readData);
+    }
+}
+
+TEST(AsyncStreamTest, ErrorPropagatesToWait) {
+    AsyncExecutor executor{1};
+    executor.Spawn([]() -> Task<void> {
+        SyncInputAdapter input{std::make_unique<MemoryInputStream>(std::vector<uint8_t>{1, 2})};
+        input.Close();
+        char buffer[2];
+        co_await input.ReadBlockAsync(buffer, sizeof(buffer));
+    }());
+    ASSERT_THROW(executor.Wait(), std::logic_error);
+}
+
+TEST(TeeStreamTest, WritesEveryBranch) {
+    std::string testData;
+    for (int i = 0; i < 3000; ++i) {
+        testData += static_cast<char>(i % 7 == 0 ? 'A' : i);
+    }
+
+    for (bool threaded : {false, true}) {
+        auto plain = std::make_unique<MemoryOutputStream>();
+        auto compressed = std::make_unique<MemoryOutputStream>();
+        MemoryOutputStream* plainData = plain.get();
+        MemoryOutputStream* compressedData = compressed.get();
+
+        std::vector<IOutputPtr> children;
+        children.push_back(std::move(plain));
+        children.push_back(std::make_unique<CompressingOutputStream>(
+            std::make_unique<EncryptingOutputStream>(std::move(compressed), 5)));
+
+        TeeOutputStream output{std::move(children), threaded, 2};
+        output.WriteBlock(testData.data(), 1000);
+        for (std::size_t i = 1000; i < 1100; ++i) {
+            output.WriteByte(static_cast<uint8_t>(testData[i]));
+        }
+        output.WriteBlock(testData.data() + 1100, testData.size() - 1100);
+        output.Close();
+        ASSERT_THROW(output.WriteByte(0), std::logic_error);
+
+        ASSERT_EQ(testData, std::string(plainData->GetData().begin(), plainData->GetData().end()));
+
+        DecompressingInputStream input{std::make_unique<DecryptingInputStream>(
+            std::make_unique<MemoryInputStream>(compressedData->GetData()), 5)};
+        std::string readData;
+        char buffer[256];
+        while (!input.IsEOF()) {
+            readData.append(buffer, input.ReadBlock(buffer, sizeof(buffer)));
+        }
+        ASSERT_EQ(testData, readData);
+    }
+}
+
+TEST(TeeStreamTest, BranchErrorIsReported) {
+    auto closed = std::make_unique<MemoryOutputStream>();
+    closed->Close();
+
+    std::vector<IOutputPtr> children;
+    children.push_back(std::make_unique<MemoryOutputStream>());
+    children.push_back(std::move(closed));
+
+    TeeOutputStream output{std::move(children), true};
+    const char data[] = "data";
+    // Ошибка ветви всплывает при очередной записи или при закрытии
+    ASSERT_THROW(
+        {
+            for (int i = 0; i < 100; ++i) {
+                output.WriteBlock(data, sizeof(data));
+            }
+            output.Close();
+        },
+        std::logic_error);
+}
+
+TEST(IncrementalTransformTest, ReusesUnchangedChunks) {
+    const std::string outputFile{"temp_incremental_out.bin"};
+    const std::size_t chunkSize = 1000;
+    std::vector<uint8_t> testData(10 * chunkSize);
+    for (std::size_t i = 0; i < testData.size(); ++i) {
+        testData[i] = static_cast<uint8_t>(i / 100);
+    }
+
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Encrypt, 3});
+    pipeline.AddStage({StageKind::Compress});
+
+    auto run = [&](const std::vector<uint8_t>& data) {
+        MemoryInputStream input{data};
+        return IncrementalTransform(input, outputFile, pipeline, chunkSize);
+    };
+    auto restore = [&]() {
+        DecompressingInputStream input{std::make_unique<DecryptingInputStream>(
+            std::make_unique<FileInputStream>(outputFile), 3)};
+        std::vector<uint8_t> data;
+        uint8_t buffer[512];
+        while (!input.IsEOF()) {
+            data.insert(data.end(), buffer, buffer + input.ReadBlock(buffer, sizeof(buffer)));
+        }
+        return data;
+    };
+
+    IncrementalStats stats = run(testData);
+    ASSERT_EQ(0u, stats.ReusedChunks);
+    ASSERT_EQ(10u, stats.ProcessedChunks);
+    ASSERT_EQ(testData, restore());
+
+    // Меняем один байт - заново обрабатывается только его блок
+    testData[4321] ^= 0xFF;
+    stats = run(testData);
+    ASSERT_EQ(9u, stats.ReusedChunks);
+    ASSERT_EQ(1u, stats.ProcessedChunks);
+    ASSERT_EQ(testData, restore());
+
+    // Другая цепочка делает манифест недействительным
+    pipeline.AddStage({StageKind::Encrypt, 5});
+    stats = run(testData);
+    ASSERT_EQ(0u, stats.ReusedChunks);
+
+    std::remove(outputFile.c_str());
+    std::remove(ManifestFileName(outputFile).c_str());
+}
+
+TEST(IncrementalTransformTest, ManifestDoesNotRevealKey) {
+    const std::string outputFile{"temp_incremental_key_out.bin"};
+    const std::vector<uint8_t> testData(3000, 'k');
+
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Encrypt, 123456});
+    pipeline.AddStage({StageKind::Compress});
+    {
+        MemoryInputStream input{testData};
+        IncrementalTransform(input, outputFile, pipeline, 1000);
+    }
+
+    std::ifstream manifest{ManifestFileName(outputFile)};
+    const std::string text{std::istreambuf_iterator<char>(manifest), {}};
+    ASSERT_EQ(std::string::npos, text.find("123456"));
+    ASSERT_EQ(std::string::npos, text.find("encrypt"));
+
+    // Хеши блоков зависят от ключа: без него нельзя проверить догадку о данных
+    Pipeline otherKey;
+    otherKey.AddStage({StageKind::Encrypt, 654321});
+    otherKey.AddStage({StageKind::Compress});
+    const ChunkHashKey chunkKey = DerivePipelineSecrets(pipeline).ChunkKey;
+    ASSERT_NE(chunkKey, DerivePipelineSecrets(otherKey).ChunkKey);
+    const auto loaded = ChunkManifest::Load(ManifestFileName(outputFile));
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(HashChunk(testData.data(), 1000, chunkKey), loaded->Chunks[0].Hash);
+    ASSERT_NE(HashChunk(testData.data(), 1000, ChunkHashKey{}), loaded->Chunks[0].Hash);
+
+    std::remove(outputFile.c_str());
+    std::remove(ManifestFileName(outputFile).c_str());
+}
+
+TEST(IncrementalTransformTest, DamagedManifestIsIgnored) {
+    const std::string outputFile{"temp_incremental_damaged_out.bin"};
+    const std::string manifestFile = ManifestFileName(outputFile);
+    const std::vector<uint8_t> testData(5000, 'd');
+    Pipeline pipeline;
+    pipeline.AddStage({StageKind::Compress});
+
+    auto run = [&] {
+        MemoryInputStream input{testData};
+        return IncrementalTransform(input, outputFile, pipeline, 1000);
+    };
+    ASSERT_EQ(5u, run().ProcessedChunks);
+
+    // Огромное количество записей не должно приводить к выделению памяти под них
+    const auto fingerprint = ChunkManifest::Load(manifestFile)->PipelineFingerprint;
+    {
+        std::ofstream manifest{manifestFile, std::ios::trunc};
+        manifest << ChunkManifest::Header << ' ' << ChunkManifest::Version << '\n'
+                 << 1000 << ' ' << std::hex << fingerprint << std::dec << '\n'
+                 << std::filesystem::file_size(outputFile) << " 18446744073709551615\n";
+    }
+    ASSERT_FALSE(ChunkManifest::Load(manifestFile).has_value());
+    ASSERT_EQ(5u, run().ProcessedChunks);
+    ASSERT_EQ(5u, run().ReusedChunks);
+
+    std::remove(outputFile.c_str());
+    std::remove(manifestFile.c_str());
+}
+
+TEST(IncrementalTransformTest, FailureRemovesTemporaryFile) {
+    const std::string outputFile{"temp_incremental_fail_out.bin"};
+    const std::vector<uint8_t> testData(100, 'f');
+    MemoryInputStream input{testData};
+    input.Close();
+
+    ASSERT_THROW(IncrementalTransform(input, outputFile, Pipeline{}, 10), std::logic_error);
+    ASSERT_FALSE(std::filesystem::exists(outputFile + ".tmp"));
+    ASSERT_FALSE(std::filesystem::exists(outputFile));
+}
+
+TEST(SubstitutionTableRegistryTest, SharesTablesPerKey) {
+    auto& registry = SubstitutionTableRegistry::Instance();
+    SubstitutionTablesPtr tables = registry.Get(777);
+
+    ASSERT_EQ(tables, registry.Get(777));
+    ASSERT_NE(tables, registry.Get(778));
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(tables->Encrypt.data()) % 256);
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(tables->Decrypt.data()) % 256);
+
+    for (int i = 0; i < 256; ++i) {
+        ASSERT_EQ(i, tables->Decrypt[tables->Encrypt[i]]);
+    }
+}
+
+TEST(SubstitutionTableRegistryTest, ConcurrentGetReturnsSameTables) {
+    auto& registry = SubstitutionTableRegistry::Instance();
+    std::vector<SubstitutionTablesPtr> results(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&registry, &results, i] { results[i] = registry.Get(424242); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& result : results) {
+        ASSERT_EQ(results.front(), result);
+    }
+}
+
+TEST(SubstitutionTableRegistryTest, KeyringPreloadsKeys) {
+    ASSERT_EQ((std::vector<uint_fast32_t>{3, 100500}), ParseKeyring("3,100500"));
+    ASSERT_THROW(ParseKeyring("3,,5"), std::invalid_argument);
+    ASSERT_THROW(ParseKeyring("3x"), std::invalid_argument);
+
+    auto& registry = SubstitutionTableRegistry::Instance();
+    registry.Preload(ParseKeyring("9001,9002"));
+    const std::size_t size = registry.Size();
+    registry.Get(9001);
+    registry.Get(9002);
+    ASSERT_EQ(size, registry.Size());
+}